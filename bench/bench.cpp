@@ -0,0 +1,204 @@
+/**
+  Microbenchmarks for the extension, run with make bench.
+
+  The extension is linked in and registered as a builtin module
+  of an embedded interpreter, so the python facing paths (method
+  calls, dict construction, python sensors and switches) are
+  timed through the same code python uses, and the native ones
+  (unit conversions, the control cycle on the simulator) are
+  called directly.
+
+  Every benchmark runs for about BENCH_SECONDS and reports the
+  mean ns per operation.
+  */
+
+#include <Python.h>
+#include <stdexcept>
+#include "utils.h"
+#include "cpy.h"
+#include "control.h"
+#include "convert.h"
+#include "snapshot.h"
+#include "pyio.h"
+#include <chrono>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+
+#define BENCH_SECONDS 0.5
+
+PyMODINIT_FUNC PyInit_TempControl(void);
+
+// keeps the compiler from dropping the benchmarked work
+static volatile double sink;
+
+template<class F>
+static void bench(const char *name, F op) {
+    typedef std::chrono::steady_clock clock;
+    unsigned long ops = 0;
+    unsigned long batch = 1;
+    auto start = clock::now();
+    double elapsed = 0;
+    while(elapsed < BENCH_SECONDS) {
+        for(unsigned long n = 0; n < batch; n++) {
+            op();
+        }
+        ops += batch;
+        batch *= 2;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    }
+    printf("%-40s %12.1f ns/op\n", name, elapsed * 1e9 / ops);
+}
+
+static void benchConversions() {
+    // read every time, so the conversions can't be hoisted out of the loop
+    volatile double d = 20.0;
+    volatile temperature t = doubleToTemp(20.0);
+    bench("c2f", [&]() { sink = c2f(d); });
+    bench("f2c", [&]() { sink = f2c(d); });
+    bench("tempToDouble", [&]() { sink = tempToDouble(t); });
+    bench("doubleToTemp", [&]() { sink = doubleToTemp(d); });
+    bench("internalToUnit f", [&]() { sink = internalToUnit('f', d); });
+    bench("unitToInternal f", [&]() { sink = unitToInternal('f', d); });
+    CPyObject n(PyFloat_FromDouble(68.0));
+    bench("pyNumToTemp f", [&]() { sink = pyNumToTemp('f', n); });
+    bench("tempToPyFloat f", [&]() { CPyObject f(tempToPyFloat('f', t)); });
+    std::vector<int16_t> temps(1024, doubleToTemp(20.0));
+    std::vector<double> values(temps.size());
+    bench("tempsToUnit f, 1024 temps", [&]() { tempsToUnit('f', temps.data(), 1, values.data(), temps.size()); });
+}
+
+static CPyObject run(const char *code, PyObject *globals) {
+    return CPyObject(PyRun_String(code, Py_file_input, globals, globals));
+}
+
+// snapshot with the lowest bit of beerSetting and Kp flipped
+static CPyObject flipped(PyObject *snapshot) {
+    std::string blob(PyBytes_AS_STRING(snapshot), PyBytes_GET_SIZE(snapshot));
+    // cs, cv and cc come first, see visitState
+    size_t cs = sizeof(SnapshotHeader);
+    size_t cc = cs + sizeof(ControlSettings) + sizeof(ControlVariables);
+    blob[cs + offsetof(ControlSettings, beerSetting)] ^= 1;
+    blob[cc + offsetof(ControlConstants, Kp)] ^= 1;
+    return CPyObject(PyBytes_FromStringAndSize(blob.data(), blob.size()));
+}
+
+static void benchMethods() {
+    CPyObject main(PyImport_AddModule("__main__"), true);
+    PyObject *globals = PyModule_GetDict(main);
+    run("import TempControl\n"
+        "class Sensor:\n"
+        "    def read(self, unit=None):\n"
+        "        return 20.0\n"
+        "class Switch:\n"
+        "    def on(self):\n"
+        "        pass\n"
+        "    def off(self):\n"
+        "        pass\n"
+        "tc = TempControl.TempControl(unit='f')\n"
+        "tc.setBeerSensor(Sensor())\n"
+        "tc.setFridgeSensor(Sensor())\n"
+        "tc.setHeater(Switch())\n"
+        "tc.setCooler(Switch())\n"
+        "tc.init()\n"
+        "tc.loadDefaultSettings()\n"
+        "tc.loadDefaultConstants()\n"
+        "tc.setMode(TempControl.MODE_BEER_CONSTANT)\n"
+        "tc.setBeerTemp(f=68)\n", globals);
+    CPyObject tc(getFromDict(globals, "tc"));
+    CPyObject sensor(getFromDict(globals, "Sensor"));
+    CPyObject s(PyObject_CallObject(sensor, NULL));
+    CPyObject sw(PyObject_CallObject(CPyObject(getFromDict(globals, "Switch")), NULL));
+
+    // unchanged settings and constants come from the cache
+    bench("getControlConstants, cached", [&]() { CPyObject r(PyObject_CallMethod(tc, "getControlConstants", NULL)); });
+    bench("getControlSettings, cached", [&]() { CPyObject r(PyObject_CallMethod(tc, "getControlSettings", NULL)); });
+
+    /*
+       Restoring two snapshots in turn changes cs and cc every
+       time, so the getters below build their dicts anew; the
+       restore alone is timed too, subtract it
+       */
+    CPyObject snapshots[2];
+    snapshots[0].reset(PyObject_CallMethod(tc, "snapshot", NULL));
+    snapshots[1] = flipped(snapshots[0]);
+    unsigned long turn = 0;
+    auto restore = [&]() {
+        CPyObject r(PyObject_CallMethod(tc, "restore", "O", (PyObject *) snapshots[turn++ & 1]));
+    };
+    bench("restore, alternating", restore);
+    bench("getControlConstants + restore", [&]() {
+        restore();
+        CPyObject r(PyObject_CallMethod(tc, "getControlConstants", NULL));
+    });
+    bench("getControlSettings + restore", [&]() {
+        restore();
+        CPyObject r(PyObject_CallMethod(tc, "getControlSettings", NULL));
+    });
+    // back to the state the benchmarks below start from
+    CPyObject r(PyObject_CallMethod(tc, "restore", "O", (PyObject *) snapshots[0]));
+    bench("getState", [&]() { CPyObject r(PyObject_CallMethod(tc, "getState", NULL)); });
+    /*
+       A python sensor and switch as the control cycle calls them,
+       with the GIL released and taken back around every call.  The
+       tick below pays for two reads and, on a change, two writes.
+       */
+    PyBasicTempSensor basic(s);
+    TempSensor temp(TEMP_SENSOR_TYPE_BEER, &basic);
+    PyActuator actuator(sw, 0);
+    temp.init();
+    {
+        GILRelease nogil;
+        bench("python sensor update", [&]() { temp.update(); });
+        bool on = false;
+        bench("python switch toggle", [&]() { actuator.setActive(on = !on); });
+    }
+    bench("tick, python sensors and switches", [&]() { CPyObject r(PyObject_CallMethod(tc, "tick", NULL)); });
+}
+
+static void benchCycle() {
+    Simulator sim(PlantParams{});
+    SimTempSensor basicBeer(&sim.beerTemp);
+    SimTempSensor basicFridge(&sim.fridgeTemp);
+    TempSensor beer(TEMP_SENSOR_TYPE_BEER, &basicBeer);
+    TempSensor fridge(TEMP_SENSOR_TYPE_FRIDGE, &basicFridge);
+    SimActuator heater(&sim.heating);
+    SimActuator cooler(&sim.cooling);
+
+    ClockScope scope(&sim.clock);
+    beer.init();
+    fridge.init();
+
+    TempControlRefs refs;
+    TempControl &tc = refs.controller();
+    tc.beerSensor = &beer;
+    tc.fridgeSensor = &fridge;
+    tc.heater = &heater;
+    tc.cooler = &cooler;
+    tc.init();
+    tc.loadDefaultSettings();
+    tc.loadDefaultConstants();
+    tc.setMode(MODE_BEER_CONSTANT);
+    tc.setBeerTemp(doubleToTemp(18.0));
+
+    bench("control cycle, simulated plant", [&]() {
+        sim.step(1.0);
+        sim.clock.advance(1000);
+        sink = refs.tick().newState;
+    });
+}
+
+int main(int argc, char **argv) {
+    PyImport_AppendInittab("TempControl", PyInit_TempControl);
+    Py_Initialize();
+    try {
+        benchConversions();
+        benchMethods();
+        benchCycle();
+    } catch(...) {
+        PyErr_Print();
+        return 1;
+    }
+    Py_Finalize();
+    return 0;
+}
@@ -25,14 +25,9 @@ class FermLoop:
             time.sleep(max(0, nextSampleTime - time.time()))
             nextSampleTime += 1
 
-            tempControl.updateTemperatures()
-            tempControl.detectPeaks()
-            tempControl.updatePID()
-            oldState = tempControl.getState()
-            tempControl.updateState()
-            if(oldState != tempControl.getState()):
-                c.print("state change")
-            tempControl.updateOutputs() # doesn't really do anything
+            oldState, newState, changed = tempControl.tick()
+            if(changed):
+                print("state change")
             fermvars = {}
             cs = tempControl.getControlSettings()
             for k in cs.keys():
@@ -0,0 +1,57 @@
+/**
+  Change tracking, see changes.h
+  */
+
+#include "changes.h"
+
+#define TRACKED(group, name, kind) \
+    {#group "." #name, [](TempControl &tc) -> long { return tc.group.name; }, kind}
+
+const TrackedField trackedFields[] = {
+    TRACKED(cs, mode, TRACKED_INT),
+    TRACKED(cs, beerSetting, TRACKED_TEMP),
+    TRACKED(cs, fridgeSetting, TRACKED_TEMP),
+    TRACKED(cs, heatEstimator, TRACKED_TEMP_DIFF),
+    TRACKED(cs, coolEstimator, TRACKED_TEMP_DIFF),
+    TRACKED(cv, beerDiff, TRACKED_TEMP_DIFF),
+    TRACKED(cv, diffIntegral, TRACKED_LONG_TEMP_DIFF),
+    TRACKED(cv, beerSlope, TRACKED_TEMP_DIFF),
+    TRACKED(cv, p, TRACKED_LONG_TEMP_DIFF),
+    TRACKED(cv, i, TRACKED_LONG_TEMP_DIFF),
+    TRACKED(cv, d, TRACKED_LONG_TEMP_DIFF),
+    TRACKED(cv, estimatedPeak, TRACKED_TEMP_DIFF),
+    TRACKED(cv, negPeakEstimate, TRACKED_TEMP_DIFF),
+    TRACKED(cv, posPeakEstimate, TRACKED_TEMP_DIFF),
+    TRACKED(cv, negPeak, TRACKED_TEMP_DIFF),
+    TRACKED(cv, posPeak, TRACKED_TEMP_DIFF),
+    {"state", [](TempControl &tc) -> long { return tc.getState(); }, TRACKED_INT},
+    {"heater", [](TempControl &tc) -> long { return tc.heater->isActive(); }, TRACKED_BOOL},
+    {"cooler", [](TempControl &tc) -> long { return tc.cooler->isActive(); }, TRACKED_BOOL},
+};
+
+const size_t TRACKED_FIELD_COUNT = sizeof(trackedFields) / sizeof(trackedFields[0]);
+
+static_assert(sizeof(trackedFields) / sizeof(trackedFields[0]) <= TRACKED_FIELD_MAX, "raise TRACKED_FIELD_MAX");
+
+ChangeTracker::ChangeTracker() {
+    for(size_t n = 0; n < TRACKED_FIELD_MAX; n++) {
+        changed[n] = 0;
+        values[n] = 0;
+    }
+}
+
+void ChangeTracker::update(TempControl &tc) {
+    bool any = false;
+    for(size_t n = 0; n < TRACKED_FIELD_COUNT; n++) {
+        long v = trackedFields[n].read(tc);
+        if(!primed || v != values[n]) {
+            if(!any) {
+                version++;
+                any = true;
+            }
+            values[n] = v;
+            changed[n] = version;
+        }
+    }
+    primed = true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+/**
+  ChangeTracker finds which of cs, cv, the state and the heater/
+  cooler outputs moved, so telemetry can publish only those
+  instead of diffing whole dicts.  Once a chamber has a tracker
+  every tick compares the tracked fields against the previous
+  tick and stamps the ones that changed with a new version;
+  changesSince(token) then only has to look at the stamps.
+  */
+
+#include "TempControl.h"
+
+enum TrackedKind {
+    TRACKED_TEMP,
+    TRACKED_TEMP_DIFF,
+    // the long_temperature fields of cv
+    TRACKED_LONG_TEMP_DIFF,
+    TRACKED_INT,
+    TRACKED_BOOL
+};
+
+struct TrackedField {
+    // "cs.beerSetting", "cv.p", "state", "heater", ...
+    const char *name;
+    long (*read)(TempControl &tc);
+    TrackedKind kind;
+};
+
+extern const TrackedField trackedFields[];
+extern const size_t TRACKED_FIELD_COUNT;
+
+#define TRACKED_FIELD_MAX 32
+
+class ChangeTracker {
+    public:
+        ChangeTracker();
+
+        /*
+           Compares every field with the last update, the changed
+           ones get the next version.  The first update marks all
+           fields as changed.
+           */
+        void update(TempControl &tc);
+
+        // version of the last update that found a change
+        unsigned long version = 0;
+        // per field, the version it last changed in and its value then
+        unsigned long changed[TRACKED_FIELD_MAX];
+        long values[TRACKED_FIELD_MAX];
+
+    private:
+        bool primed = false;
+};
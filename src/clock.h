@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+
+/*
+   millis() is driven by a Clock.  Normally this is the wall
+   clock, but it can be switched to a simulated clock which
+   only moves when advanced, so the time based logic of
+   TempControl (peak detection, min on/off times, slope
+   filters) can be exercised faster than real time.
+
+   The module clock is read by scheduler threads while python
+   switches or advances it, so its state is atomic.  setSimulated
+   publishes now before simulated, a reader that sees the clock
+   simulated also sees its start.
+   */
+class Clock {
+    public:
+        Clock() : simulated(false), now(0) {}
+
+        unsigned long millis();
+
+        void setReal();
+        void setSimulated(unsigned long start);
+        void advance(unsigned long ms);
+
+        bool isSimulated() const {
+            return simulated.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::atomic<bool> simulated;
+        std::atomic<unsigned long> now;
+};
+
+// the clock millis() reads from unless a ClockScope is active
+extern Clock moduleClock;
+
+// the clock millis() reads from on this thread
+extern thread_local Clock *activeClock;
+
+/*
+   Points millis() at another clock for the lifetime of the
+   scope, used by native loops (simulate etc) that keep their
+   own time independent of the module clock.
+   */
+class ClockScope {
+    private:
+        Clock *previous;
+
+    public:
+        ClockScope(Clock *clock) {
+            previous = activeClock;
+            activeClock = clock;
+        }
+
+        ~ClockScope() {
+            activeClock = previous;
+        }
+
+        ClockScope(const ClockScope &) = delete;
+        ClockScope& operator =(const ClockScope &) = delete;
+};
@@ -3,4 +3,8 @@
 #define ARDUINO 1
 #define BREWPI_LOG_INFO 1
 #define TEMP_SENSOR_CASCADED_FILTER 1
+// build with TEMP_CONTROL_STATIC=0 to let every python
+// TempControl object own an independent controller
+#ifndef TEMP_CONTROL_STATIC
 #define TEMP_CONTROL_STATIC 1
+#endif
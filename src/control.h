@@ -0,0 +1,207 @@
+#pragma once
+
+#include "TempControl.h"
+#include "TempSensorDisconnected.h"
+#include "simulator.h"
+#include "recorder.h"
+#include "eeprom.h"
+#include "stats.h"
+#include "changes.h"
+#include "profile.h"
+#include "logring.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string.h>
+
+/*
+   Runs one full control cycle, the same sequence example.py
+   used to drive from python one call at a time.  Returns
+   the state before and after updateState.
+   */
+struct TickResult {
+    unsigned char oldState;
+    unsigned char newState;
+};
+
+inline TickResult
+tickControl(TempControl &tc) {
+    TickResult r;
+    {
+        TIME_STAGE("tick.updateTemperatures");
+        tc.updateTemperatures();
+    }
+    {
+        TIME_STAGE("tick.detectPeaks");
+        tc.detectPeaks();
+    }
+    {
+        TIME_STAGE("tick.updatePID");
+        tc.updatePID();
+    }
+    r.oldState = tc.getState();
+    {
+        TIME_STAGE("tick.updateState");
+        tc.updateState();
+    }
+    r.newState = tc.getState();
+    {
+        TIME_STAGE("tick.updateOutputs");
+        tc.updateOutputs();
+    }
+    return r;
+}
+
+// ids of chambers, from 1, 0 is no chamber
+inline uint32_t
+nextChamberId() {
+    static std::atomic<uint32_t> last{0};
+    return ++last;
+}
+
+// defaults defined in extra.cpp
+extern ValueSensor<bool> defaultSensor;
+extern ValueActuator defaultActuator;
+extern DisconnectedTempSensor defaultTempSensor;
+
+/*
+   The object stores any items that were
+   set on tempControl that need to be freed
+   later.
+
+   When built without TEMP_CONTROL_STATIC the
+   controller itself lives here as well, so every
+   python object drives its own chamber.
+   */
+
+class TempControlRefs {
+    public:
+#if !TEMP_CONTROL_STATIC
+        TempControl tempControl;
+#endif
+        std::unique_ptr<BasicTempSensor> basicBeerSensor;
+        std::unique_ptr<TempSensor> beerSensor;
+        std::unique_ptr<BasicTempSensor> basicFridgeSensor;
+        std::unique_ptr<TempSensor> fridgeSensor;
+        std::unique_ptr<Actuator> heater;
+        std::unique_ptr<Actuator> cooler;
+        std::unique_ptr<Simulator> simulator;
+
+        // tags the log records of this chamber
+        const uint32_t id;
+
+        std::shared_ptr<Recorder> recorder;
+
+        // sets the beer setting every tick while in MODE_BEER_PROFILE
+        std::unique_ptr<TempProfile> profile;
+
+        // created by the first changesSince, updated every tick from then on
+        std::unique_ptr<ChangeTracker> changes;
+
+        // where save/load keep the settings and constants
+        std::unique_ptr<Eeprom> eeprom;
+
+        // held while the controller runs, the GIL is not, see ChamberLock
+        std::mutex lock;
+        // bumped every time lock is taken
+        std::atomic<unsigned long> epoch{0};
+
+        /*
+           generation counts changes to cs and cc, whoever made
+           them (a setter, a tick moving fridgeSetting, restore).
+           noteChanges compares them to what it saw last time, call
+           it under the lock before reading them.
+           */
+        unsigned long generation = 0;
+        unsigned long settingsGeneration = 0;
+        unsigned long constantsGeneration = 0;
+        ControlSettings seenSettings;
+        ControlConstants seenConstants;
+
+        TempControlRefs() : id(nextChamberId()) {
+#if !TEMP_CONTROL_STATIC
+            // the static build gets these from the field
+            // definitions in TempControl.cpp, an instance
+            // starts out with garbage so mirror them here
+            beerSensor = std::make_unique<TempSensor>(TEMP_SENSOR_TYPE_BEER, &defaultTempSensor);
+            beerSensor->init();
+            fridgeSensor = std::make_unique<TempSensor>(TEMP_SENSOR_TYPE_FRIDGE, &defaultTempSensor);
+            fridgeSensor->init();
+            tempControl.beerSensor = beerSensor.get();
+            tempControl.fridgeSensor = fridgeSensor.get();
+            tempControl.ambientSensor = &defaultTempSensor;
+            tempControl.heater = &defaultActuator;
+            tempControl.cooler = &defaultActuator;
+            tempControl.light = &defaultActuator;
+            tempControl.fan = &defaultActuator;
+            tempControl.door = &defaultSensor;
+            memset(&tempControl.cs, 0, sizeof(tempControl.cs));
+            memset(&tempControl.cv, 0, sizeof(tempControl.cv));
+            memset(&tempControl.cc, 0, sizeof(tempControl.cc));
+#endif
+            memset(&seenSettings, 0, sizeof(seenSettings));
+            memset(&seenConstants, 0, sizeof(seenConstants));
+        }
+
+        TempControl &controller() {
+#if TEMP_CONTROL_STATIC
+            return ::tempControl;
+#else
+            return tempControl;
+#endif
+        }
+
+        void noteChanges() {
+            TempControl &tc = controller();
+            if(memcmp(&seenSettings, &tc.cs, sizeof(seenSettings)) != 0) {
+                memcpy(&seenSettings, &tc.cs, sizeof(seenSettings));
+                settingsGeneration++;
+                generation++;
+            }
+            if(memcmp(&seenConstants, &tc.cc, sizeof(seenConstants)) != 0) {
+                memcpy(&seenConstants, &tc.cc, sizeof(seenConstants));
+                constantsGeneration++;
+                generation++;
+            }
+        }
+
+        /*
+           One control cycle of this chamber, the profile, the
+           controller, then whatever is attached to it
+           */
+        TickResult tick() {
+            if(profile && controller().cs.mode == MODE_BEER_PROFILE) {
+                TIME_STAGE("tick.profile");
+                profile->apply(controller());
+            }
+            TickResult r = tickControl(controller());
+            if(recorder) {
+                recorder->record(controller(), r);
+            }
+            if(changes) {
+                changes->update(controller());
+            }
+            return r;
+        }
+};
+
+/*
+   Holds the lock of a chamber, bumping its epoch first.  Anything
+   that changes a chamber does so under a ChamberLock, so a copy
+   made under the lock while the epoch was e is still current as
+   long as the epoch reads e.  What the controller logs meanwhile
+   is tagged with the chamber's id.
+   */
+class ChamberLock {
+    private:
+        std::lock_guard<std::mutex> guard;
+        LogChamberScope logScope;
+
+    public:
+        ChamberLock(TempControlRefs &refs) : guard(refs.lock), logScope(refs.id) {
+            refs.epoch.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        ChamberLock(const ChamberLock &) = delete;
+        ChamberLock& operator =(const ChamberLock &) = delete;
+};
@@ -0,0 +1,79 @@
+/**
+  Batch temperature conversion, see convert.h.  Built with -O3 so
+  the contiguous loops vectorize, the unit is a template parameter
+  so they have no branches.
+  */
+
+#include "convert.h"
+
+template<char unit>
+static void tempsToUnitLoop(const int16_t *in, ptrdiff_t inStride, double *out, size_t n) {
+    if(inStride == 1) {
+        for(size_t i = 0; i < n; i++) {
+            out[i] = tempToUnit(unit, in[i]);
+        }
+    } else {
+        for(size_t i = 0; i < n; i++) {
+            out[i] = tempToUnit(unit, in[i * inStride]);
+        }
+    }
+}
+
+template<char unit, class T>
+static void tempDiffsToUnitLoop(const T *in, ptrdiff_t inStride, double *out, size_t n) {
+    if(inStride == 1) {
+        for(size_t i = 0; i < n; i++) {
+            out[i] = tempDiffToUnit(unit, in[i]);
+        }
+    } else {
+        for(size_t i = 0; i < n; i++) {
+            out[i] = tempDiffToUnit(unit, in[i * inStride]);
+        }
+    }
+}
+
+template<char unit>
+static void unitsToTempsLoop(const double *in, ptrdiff_t inStride, int16_t *out, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        double v = in[i * inStride];
+        out[i] = v != v ? INVALID_TEMP : unitToTemp(unit, v);
+    }
+}
+
+void tempsToUnit(char unit, const int16_t *in, ptrdiff_t inStride, double *out, size_t n) {
+    if(unit == 'c') {
+        tempsToUnitLoop<'c'>(in, inStride, out, n);
+    } else {
+        tempsToUnitLoop<'f'>(in, inStride, out, n);
+    }
+    // a separate pass keeps the loops above branch free
+    for(size_t i = 0; i < n; i++) {
+        if(in[i * inStride] == INVALID_TEMP) {
+            out[i] = NAN;
+        }
+    }
+}
+
+void tempDiffsToUnit(char unit, const int16_t *in, ptrdiff_t inStride, double *out, size_t n) {
+    if(unit == 'c') {
+        tempDiffsToUnitLoop<'c'>(in, inStride, out, n);
+    } else {
+        tempDiffsToUnitLoop<'f'>(in, inStride, out, n);
+    }
+}
+
+void tempDiffsToUnit(char unit, const int32_t *in, ptrdiff_t inStride, double *out, size_t n) {
+    if(unit == 'c') {
+        tempDiffsToUnitLoop<'c'>(in, inStride, out, n);
+    } else {
+        tempDiffsToUnitLoop<'f'>(in, inStride, out, n);
+    }
+}
+
+void unitsToTemps(char unit, const double *in, ptrdiff_t inStride, int16_t *out, size_t n) {
+    if(unit == 'c') {
+        unitsToTempsLoop<'c'>(in, inStride, out, n);
+    } else {
+        unitsToTempsLoop<'f'>(in, inStride, out, n);
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+/**
+  Exact conversions between the fixed point temperature type and
+  celsius/fahrenheit.
+
+  A temperature is an integer number of 1/512 degrees celsius (plus
+  C_OFFSET), so in fahrenheit it is the exact fraction
+
+      (t - C_OFFSET) * 9 / 2560 + 32
+
+  which is computed in integers and divided once, the result is the
+  double closest to the true value.  Going the other way the value
+  is rounded once to the nearest 1/512 degree, so converting a
+  temperature out and back in always gives the same temperature.
+  Going through c2f/f2c rounded at every step and needed
+  shortenDouble to hide it.
+
+  The batch kernels convert whole arrays, eg recorded histories,
+  with loops simple enough for the compiler to vectorize.  They
+  map INVALID_TEMP to nan and back.
+  */
+
+#include "TemperatureFormats.h"
+#include <math.h>
+#include <stddef.h>
+
+// 32 degrees fahrenheit in 1/2560 degrees
+#define F_OFFSET_FIXED (32 * 5 * TEMP_FIXED_POINT_SCALE)
+
+inline double tempToUnit(char unit, temperature t) {
+    int32_t c = int32_t(t) - C_OFFSET;
+    if(unit == 'c') {
+        return c / double(TEMP_FIXED_POINT_SCALE);
+    }
+    return (c * 9 + F_OFFSET_FIXED) / double(5 * TEMP_FIXED_POINT_SCALE);
+}
+
+inline double tempDiffToUnit(char unit, long_temperature t) {
+    if(unit == 'c') {
+        return t / double(TEMP_FIXED_POINT_SCALE);
+    }
+    return (int64_t(t) * 9) / double(5 * TEMP_FIXED_POINT_SCALE);
+}
+
+// v in 1/512 degrees celsius, not yet rounded
+inline double unitToFixed(char unit, double v) {
+    if(unit == 'c') {
+        return v * TEMP_FIXED_POINT_SCALE;
+    }
+    return (v - 32) * (5 * TEMP_FIXED_POINT_SCALE) / 9;
+}
+
+inline double unitDiffToFixed(char unit, double v) {
+    if(unit == 'c') {
+        return v * TEMP_FIXED_POINT_SCALE;
+    }
+    return v * (5 * TEMP_FIXED_POINT_SCALE) / 9;
+}
+
+inline temperature unitToTemp(char unit, double v) {
+    double fixed = floor(unitToFixed(unit, v) + 0.5) + C_OFFSET;
+    if(!(fixed >= MIN_TEMP)) {
+        return MIN_TEMP;
+    }
+    if(fixed > MAX_TEMP) {
+        return MAX_TEMP;
+    }
+    return temperature(fixed);
+}
+
+inline long_temperature unitToTempDiff(char unit, double v) {
+    double fixed = floor(unitDiffToFixed(unit, v) + 0.5);
+    if(!(fixed >= INT32_MIN)) {
+        return INT32_MIN;
+    }
+    if(fixed > INT32_MAX) {
+        return INT32_MAX;
+    }
+    return long_temperature(fixed);
+}
+
+/*
+   Batch kernels, in and out are n elements apart by their strides
+   (in elements, not bytes)
+   */
+void tempsToUnit(char unit, const int16_t *in, ptrdiff_t inStride, double *out, size_t n);
+void tempDiffsToUnit(char unit, const int16_t *in, ptrdiff_t inStride, double *out, size_t n);
+void tempDiffsToUnit(char unit, const int32_t *in, ptrdiff_t inStride, double *out, size_t n);
+void unitsToTemps(char unit, const double *in, ptrdiff_t inStride, int16_t *out, size_t n);
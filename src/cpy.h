@@ -4,6 +4,11 @@
 // at it moves their decref to the destructor           
 #include <Python.h>
 
+// vectorcall went public in 3.9
+#if PY_VERSION_HEX < 0x03090000
+#define PyObject_Vectorcall _PyObject_Vectorcall
+#endif
+
 class CPyObject {
     private:
         PyObject *o = nullptr;
@@ -84,3 +89,59 @@ class CPyObject {
             return *this;
         }
 };
+
+/*
+   Releases the GIL for the lifetime of the scope, the
+   GIL is taken back even when an exception leaves it
+   */
+class GILRelease {
+    private:
+        PyThreadState *state;
+
+    public:
+        GILRelease() {
+            state = PyEval_SaveThread();
+        }
+
+        ~GILRelease() {
+            PyEval_RestoreThread(state);
+        }
+
+        GILRelease(const GILRelease &) = delete;
+        GILRelease& operator =(const GILRelease &) = delete;
+};
+
+/*
+   Holds the GIL for the lifetime of the scope, for code
+   that calls back into python from native code which may
+   be running with the GIL released
+   */
+class GILAcquire {
+    private:
+        PyGILState_STATE state;
+
+    public:
+        GILAcquire() {
+            state = PyGILState_Ensure();
+        }
+
+        ~GILAcquire() {
+            PyGILState_Release(state);
+        }
+
+        GILAcquire(const GILAcquire &) = delete;
+        GILAcquire& operator =(const GILAcquire &) = delete;
+};
+
+
+/*
+   Gives a native thread a python thread state for the lifetime
+   of the scope, without holding the GIL.  GILAcquire inside the
+   scope reuses it, so an exception set under one GILAcquire is
+   still there under the next.
+   */
+class PyThreadScope {
+    private:
+        GILAcquire gil;
+        GILRelease nogil;
+};
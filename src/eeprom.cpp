@@ -0,0 +1,128 @@
+/**
+  File backed EEPROM, see eeprom.h
+  */
+
+#include "eeprom.h"
+#include <stdexcept>
+#include "utils.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+thread_local Eeprom *activeEeprom = nullptr;
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len) {
+    crc = ~crc;
+    for(size_t n = 0; n < len; n++) {
+        crc ^= data[n];
+        for(int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t bankCrc(uint32_t sequence, const uint8_t *data, size_t size) {
+    return crc32(crc32(0, (const uint8_t *) &sequence, sizeof(sequence)), data, size);
+}
+
+Eeprom::Eeprom(const char *path, size_t size) : path(path), size(size), image(size, 0xff) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        pyerr_printf("could not open eeprom %s: %s", path, strerror(errno));
+        throw std::exception();
+    }
+    size_t length = 2 * (sizeof(EepromBank) + size);
+    struct stat st;
+    if(fstat(fd, &st) < 0 || ((size_t) st.st_size != length && ftruncate(fd, length) < 0)) {
+        pyerr_printf("could not size eeprom %s: %s", path, strerror(errno));
+        close(fd);
+        throw std::exception();
+    }
+    void *m = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(m == MAP_FAILED) {
+        pyerr_printf("could not map eeprom %s: %s", path, strerror(errno));
+        throw std::exception();
+    }
+    map = (char *) m;
+
+    // a bank of another size, or one that was being written, is ignored
+    for(int n = 0; n < 2; n++) {
+        const EepromBank *h = header(n);
+        if(memcmp(h->magic, EEPROM_MAGIC, 4) != 0 || h->size != size
+                || h->crc != bankCrc(h->sequence, data(n), size)) {
+            continue;
+        }
+        if(h->sequence > sequence) {
+            sequence = h->sequence;
+            bank = n;
+        }
+    }
+    if(sequence != 0) {
+        memcpy(image.data(), data(bank), size);
+    }
+}
+
+Eeprom::~Eeprom() {
+    munmap(map, 2 * (sizeof(EepromBank) + size));
+}
+
+void Eeprom::check(size_t offset, size_t n) const {
+    if(offset > size || n > size - offset) {
+        GILAcquire gil;
+        pyerr_printf("eeprom access out of range: %zu+%zu", offset, n);
+        throw std::exception();
+    }
+}
+
+void Eeprom::read(void *dst, size_t offset, size_t n) const {
+    check(offset, n);
+    memcpy(dst, image.data() + offset, n);
+}
+
+void Eeprom::update(const void *src, size_t offset, size_t n) {
+    check(offset, n);
+    if(memcmp(image.data() + offset, src, n) != 0) {
+        memcpy(image.data() + offset, src, n);
+        dirty = true;
+    }
+}
+
+void Eeprom::commit() {
+    if(!dirty) {
+        return;
+    }
+    int next = 1 - bank;
+    EepromBank *h = header(next);
+    size_t length = sizeof(EepromBank) + size;
+    // invalid until everything else is on disk
+    memset(h->magic, 0, sizeof(h->magic));
+    h->sequence = sequence + 1;
+    h->size = size;
+    memcpy(data(next), image.data(), size);
+    h->crc = bankCrc(h->sequence, data(next), size);
+    // msync wants page aligned addresses
+    long page = sysconf(_SC_PAGESIZE);
+    char *start = (char *) ((uintptr_t) h & ~(uintptr_t) (page - 1));
+    size_t span = (char *) h + length - start;
+    if(msync(start, span, MS_SYNC) < 0) {
+        int err = errno;
+        GILAcquire gil;
+        pyerr_printf("could not write eeprom %s: %s", path.c_str(), strerror(err));
+        throw std::exception();
+    }
+    memcpy(h->magic, EEPROM_MAGIC, sizeof(h->magic));
+    if(msync(start, span, MS_SYNC) < 0) {
+        int err = errno;
+        GILAcquire gil;
+        pyerr_printf("could not write eeprom %s: %s", path.c_str(), strerror(err));
+        throw std::exception();
+    }
+    sequence++;
+    bank = next;
+    dirty = false;
+}
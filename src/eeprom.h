@@ -0,0 +1,96 @@
+#pragma once
+
+/**
+  Emulates the avr EEPROM (eeprom_read_block/eeprom_update_block)
+  with a memory mapped file, so TempControl.loadSettings and
+  friends persist across restarts.
+
+  The file holds two banks, each an EepromBank header followed by
+  the data.  An update writes the whole image to the bank not in
+  use and only then marks it valid, so a crash at any point leaves
+  at least the previous image readable.  Opening picks the valid
+  bank with the highest sequence number.
+
+  Reads and updates go to an in memory image, commit() writes it
+  out.
+  */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#define EEPROM_MAGIC "BPEE"
+#define EEPROM_DEFAULT_SIZE 1024
+
+struct EepromBank {
+    char magic[4];
+    uint32_t sequence;
+    uint32_t size;
+    // crc32 of sequence and data
+    uint32_t crc;
+};
+
+class Eeprom {
+    public:
+        Eeprom(const char *path, size_t size);
+        ~Eeprom();
+
+        // false if the file held no valid image, it then reads erased (0xff)
+        bool loaded() const {
+            return sequence != 0;
+        }
+
+        void read(void *dst, size_t offset, size_t n) const;
+        void update(const void *src, size_t offset, size_t n);
+
+        // writes the image out if it changed since the last commit
+        void commit();
+
+        Eeprom(const Eeprom &) = delete;
+        Eeprom& operator =(const Eeprom &) = delete;
+
+    private:
+        std::string path;
+        char *map;
+        size_t size;
+        std::vector<uint8_t> image;
+        uint32_t sequence = 0;
+        int bank = 1;
+        bool dirty = false;
+
+        EepromBank *header(int n) const {
+            return (EepromBank *) (map + n * (sizeof(EepromBank) + size));
+        }
+
+        uint8_t *data(int n) const {
+            return (uint8_t *) (header(n) + 1);
+        }
+
+        void check(size_t offset, size_t n) const;
+};
+
+// the eeprom eeprom_read_block/eeprom_update_block use on this thread
+extern thread_local Eeprom *activeEeprom;
+
+/*
+   Points the eeprom functions at eeprom for the lifetime of the
+   scope, like ClockScope
+   */
+class EepromScope {
+    private:
+        Eeprom *previous;
+
+    public:
+        EepromScope(Eeprom *eeprom) {
+            previous = activeEeprom;
+            activeEeprom = eeprom;
+        }
+
+        ~EepromScope() {
+            activeEeprom = previous;
+        }
+
+        EepromScope(const EepromScope &) = delete;
+        EepromScope& operator =(const EepromScope &) = delete;
+};
@@ -19,6 +19,9 @@
 #include <typeinfo>
 #include "utils.h"
 #include "cpy.h"
+#include "clock.h"
+#include "eeprom.h"
+#include "logring.h"
 #include <memory>
 
 // defaults taken from DeviceManager.cpp
@@ -40,28 +43,37 @@ void delay(unsigned long v) {
     throw std::exception();
 }
 
-// called only when TempControl.load is called
+static Eeprom *eeprom() {
+    if(activeEeprom == nullptr) {
+        GILAcquire gil;
+        PyErr_SetString(PyExc_RuntimeError, "no eeprom, see setEeprom");
+        throw std::exception();
+    }
+    return activeEeprom;
+}
+
+// called only when TempControl.load is called, the address is the eeprom offset
 void eeprom_read_block(void *__dst, const void *__src, size_t __n) {
-    PyErr_SetString(PyExc_RuntimeError, "unimplemented: eeprom_read_block"); 
-    throw std::exception();
+    eeprom()->read(__dst, (uintptr_t) __src, __n);
 }
 
 // called only when TempControl.save is called
 void eeprom_update_block(const void *__src, void *__dst, size_t __n) {
-    PyErr_SetString(PyExc_RuntimeError, "unimplemented: eeprom_update_block"); 
-    throw std::exception();
+    eeprom()->update(__src, (uintptr_t) __dst, __n);
 }
 
 /*
    The following methods are actually called and need impl
    */
-// called from TempControl, like once
+// called from TempControl, possibly without the GIL, see logring.h
 void Logger::logMessageVaArg(char type, LOG_ID_TYPE errorID, const char * varTypes, ...) {
-    // logger too weird to implement, don't care about log messages right now
+    va_list args;
+    va_start(args, varTypes);
+    logRing.push(type, errorID, varTypes, args);
+    va_end(args);
 }
 
-// used by Ticks
-unsigned long millis() {
+static unsigned long wallMillis() {
     struct timeval tv;
     gettimeofday(&tv, NULL);
     unsigned long long millisecondsSinceEpoch =
@@ -70,6 +82,34 @@ unsigned long millis() {
     return millisecondsSinceEpoch;
 }
 
+Clock moduleClock;
+thread_local Clock *activeClock = &moduleClock;
+
+unsigned long Clock::millis() {
+    if(simulated.load(std::memory_order_acquire)) {
+        return now.load(std::memory_order_relaxed);
+    }
+    return wallMillis();
+}
+
+void Clock::setReal() {
+    simulated.store(false, std::memory_order_release);
+}
+
+void Clock::setSimulated(unsigned long start) {
+    now.store(start, std::memory_order_relaxed);
+    simulated.store(true, std::memory_order_release);
+}
+
+void Clock::advance(unsigned long ms) {
+    now.fetch_add(ms, std::memory_order_relaxed);
+}
+
+// used by Ticks
+unsigned long millis() {
+    return activeClock->millis();
+}
+
 // called from TempControl whenever temp changes
 void EepromManager::storeTempSettings() {
     // do nothing, temp is provided by construction
@@ -19,143 +19,107 @@
 #include <typeinfo>
 #include "utils.h"
 #include "cpy.h"
+#include "clock.h"
+#include "control.h"
+#include "replay.h"
+#include "sweep.h"
+#include "w1sensor.h"
+#include "gpio.h"
+#include "snapshot.h"
+#include "logring.h"
+#include "stats.h"
+#include "convert.h"
+#include "scheduler.h"
+#include "pyio.h"
+#include <algorithm>
 #include <memory>
+#include <random>
+#include <thread>
 
-/*
-   PyBasicTempSensor wraps a BasicTempSensor.  It calls
-   into python to find temperature data.
-
-   python interface
-
-   class Sensor:
-
-       def read(unit=[c|f])
-   
-   */
-class PyBasicTempSensor : public BasicTempSensor {
-
-    private:
-        CPyObject py_sensor;
-
-    public:
-        PyBasicTempSensor(CPyObject py_sensor) {
-            this->py_sensor = py_sensor;
-        }
-
-        bool isConnected(void) {
-            return true;
-        }
-
-        bool init(void) {
-        }
-
-        temperature read() {
-            CPyObject m(PyObject_GetAttrString(this->py_sensor, "read"));
-            CPyObject kw(PyDict_New());
-            CPyObject unit(PyUnicode_FromString("c"));
-            PyDict_SetItemString(kw, "unit", unit);
-            CPyObject args(PyTuple_New(0));
-            CPyObject r(PyObject_Call(m, args, kw));
-            
-            temperature temp;
-            if(r == Py_None) {
-                temp = TEMP_SENSOR_DISCONNECTED;
-            } else {
-                temp = pyNumToTemp('c', r);
-            }
-
-            return temp;
-        }
-
-};
-
-/*
-   PyActuator is a wrapper around actuator.  It calls into
-   python to set a switch on/off
-   The pthon class needs an on and off method
-
-   python interface
-
-   class Switch:
-
-       def on()
-
-       def off()
-   
-   */
-class PyActuator : public Actuator {
-
-    private:
-        CPyObject py_switch;
-
-    public:
-        PyActuator(CPyObject py_switch) {
-            this->py_switch = py_switch;
-        }
-
-        void setActive(bool active) {
-            CPyObject m;
-            if(active) {
-                m.reset(PyObject_GetAttrString(this->py_switch, "on"));
-            } else {
-                m.reset(PyObject_GetAttrString(this->py_switch, "off"));
-            }
-            CPyObject r(PyObject_CallObject(m, NULL)); 
-        }
-
-        bool isActive() {
-            PyErr_SetString(PyExc_RuntimeError, "unimplemented: isActive"); 
-            throw std::exception();
-        }
-
-};
+// times a TempControl_xxx wrapper as "xxx", see stats.h
+#define TIME_METHOD() TIME_STAGE(__func__ + strlen("TempControl_"))
 
+#if TEMP_CONTROL_STATIC
 // because TempControl is a static class,
 // we only want a single "instance" of it
 // active in python at a time
 
 static bool initialized = false;
-
-/*
-   The object stores any items that were
-   set on tempControl that need to be freed
-   later.
-   */
-
-class TempControlRefs {
-    public:
-        std::unique_ptr<BasicTempSensor> basicBeerSensor;
-        std::unique_ptr<TempSensor> beerSensor;
-        std::unique_ptr<BasicTempSensor> basicFridgeSensor;
-        std::unique_ptr<TempSensor> fridgeSensor;
-        std::unique_ptr<PyActuator> heater;
-        std::unique_ptr<PyActuator> cooler;
-};
+#endif
 
 typedef struct {
     PyObject_HEAD
     TempControlRefs *refs;
     char unit;
+    // what getControlSettings/getControlConstants last returned, and for which generation
+    PyObject *settingsCache;
+    unsigned long settingsCacheGeneration;
+    PyObject *constantsCache;
+    unsigned long constantsCacheGeneration;
+    // running the cycle natively between startScheduler and stopScheduler
+    TickThread *scheduler;
+    // the Scheduler this chamber was added to, which holds a reference
+    PyObject *wheel;
 } TempControl_Object;
 
+/*
+   Runs f on the chamber with the GIL released and the chamber
+   locked, so other python threads (and other chambers) keep
+   running.  Python sensors and switches take the GIL back for
+   the duration of their callback.  The lock is only ever taken
+   without the GIL, otherwise a callback waiting for the GIL
+   could deadlock against a thread waiting for the lock.
+   */
+template<class F>
+static auto
+withChamber(TempControl_Object *self, F f) -> decltype(f(*self->refs)) {
+    GILRelease nogil;
+    ChamberLock guard(*self->refs);
+    return f(*self->refs);
+}
+
+// chambers with a scheduler running, stopped at exit
+static std::vector<TempControl_Object *> runningSchedulers;
+
+static void
+stopScheduler(TempControl_Object *self) {
+    TickThread *scheduler = self->scheduler;
+    if(scheduler == NULL) {
+        return;
+    }
+    self->scheduler = NULL;
+    runningSchedulers.erase(std::find(runningSchedulers.begin(), runningSchedulers.end(), self));
+    // the cycle may be waiting for the GIL
+    GILRelease nogil;
+    delete(scheduler);
+}
+
 static void
 TempControl_dealloc__(TempControl_Object *self) {
+    stopScheduler(self);
     delete(self->refs);
+    Py_XDECREF(self->settingsCache);
+    Py_XDECREF(self->constantsCache);
     Py_TYPE(self)->tp_free((PyObject *) self);
+#if TEMP_CONTROL_STATIC
     initialized = false;
+#endif
 }
 
 /*
    new method for python.  This exists as well as init because
-   i only want a single instance of TempControl in existence,
-   so i only allow new to succeed if initialized is false.
+   in the static build i only want a single instance of
+   TempControl in existence, so i only allow new to succeed
+   if initialized is false.
    */
 static PyObject *
 TempControl_new__(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+#if TEMP_CONTROL_STATIC
     if(initialized) {
         PyErr_SetString(PyExc_RuntimeError, "tempControl already initalized");
         return NULL;
     }
+#endif
 
     TempControl_Object *self;
     self = (TempControl_Object *) type->tp_alloc(type, 0);
@@ -163,8 +127,11 @@ TempControl_new__(PyTypeObject *type, PyObject *args, PyObject *kwds) {
         return NULL;
     }
     self->refs = new TempControlRefs();
+    self->unit = 'c';
 
+#if TEMP_CONTROL_STATIC
     initialized = true;
+#endif
 
     return (PyObject *) self;
 }
@@ -190,7 +157,7 @@ static int TempControl_init__(TempControl_Object *self, PyObject *args, PyObject
             return -1;
         }
 
-        unit = unit;
+        self->unit = unit;
 
         return 0;
     } catch(...) {
@@ -203,31 +170,75 @@ static int TempControl_init__(TempControl_Object *self, PyObject *args, PyObject
    basic initialization of the tempControl object
    */
 static PyObject *
-TempControl_init(PyObject *self, PyObject *args) {
+TempControl_init(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        tempControl.init();
+        withChamber(self, [](TempControlRefs &refs) {
+            refs.controller().init();
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
     }
 }
 
+/*
+   Both setBeerSensor and setFridgeSensor take either a python
+   sensor or the path of a w1 sysfs device, see W1TempSensor
+   */
+std::unique_ptr<BasicTempSensor> parseSetSensorArgs(PyObject *args, PyObject *kwds) {
+    PyObject *py_sensor_ = NULL;
+    const char *path = NULL;
+    static const char *kwlist[] = {"sensor", "path", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O$s", (char **) kwlist, &py_sensor_, &path)) {
+        throw std::exception();
+    }
+    if((py_sensor_ == NULL) == (path == NULL)) {
+        PyErr_SetString(PyExc_RuntimeError, "expected either a sensor or a path");
+        throw std::exception();
+    }
+    if(path != NULL) {
+        return std::make_unique<W1TempSensor>(path);
+    }
+    CPyObject py_sensor(py_sensor_, true);
+    return std::make_unique<PyBasicTempSensor>(py_sensor);
+}
+
+/*
+   Reads basic once to start the filters of sensor.  A w1 read
+   waits for a conversion, up to 750ms, so it goes without the
+   GIL; a python sensor needs it.  It runs outside the chamber's
+   lock, what it logs is still tagged with the chamber.
+   */
+static void
+initSensor(TempControlRefs &refs, TempSensor &sensor, BasicTempSensor *basic) {
+    LogChamberScope logScope(refs.id);
+    if(dynamic_cast<W1TempSensor *>(basic) != nullptr) {
+        GILRelease nogil;
+        sensor.init();
+    } else {
+        sensor.init();
+    }
+}
+
 static PyObject *
-TempControl_setBeerSensor(TempControl_Object *self, PyObject *args) {
+TempControl_setBeerSensor(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
     try {
-        PyObject *py_sensor_;
-        if(!PyArg_ParseTuple(args, "O", &py_sensor_)) {
-            return NULL;
-        }
-        CPyObject py_sensor(py_sensor_, true);
-        auto basicSensor = std::make_unique<PyBasicTempSensor>(py_sensor);
+        std::unique_ptr<BasicTempSensor> basicSensor(parseSetSensorArgs(args, kwds));
         auto sensor = std::make_unique<TempSensor>(TEMP_SENSOR_TYPE_BEER, basicSensor.get());
 
-        sensor->init();
+        initSensor(*self->refs, *sensor, basicSensor.get());
 
-        self->refs->basicBeerSensor = std::move(basicSensor);
-        self->refs->beerSensor = std::move(sensor);
-        tempControl.beerSensor = self->refs->beerSensor.get();
+        // swap in under the lock, the old sensor is freed
+        // when these go out of scope, with the GIL held
+        std::unique_ptr<BasicTempSensor> oldBasicSensor(std::move(basicSensor));
+        std::unique_ptr<TempSensor> oldSensor(std::move(sensor));
+        withChamber(self, [&](TempControlRefs &refs) {
+            std::swap(refs.basicBeerSensor, oldBasicSensor);
+            std::swap(refs.beerSensor, oldSensor);
+            refs.controller().beerSensor = refs.beerSensor.get();
+        });
 
         Py_RETURN_NONE;
     } catch(...) {
@@ -236,21 +247,23 @@ TempControl_setBeerSensor(TempControl_Object *self, PyObject *args) {
 }
 
 static PyObject *
-TempControl_setFridgeSensor(TempControl_Object *self, PyObject *args) {
+TempControl_setFridgeSensor(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
     try {
-        PyObject *py_sensor_;
-        if(!PyArg_ParseTuple(args, "O", &py_sensor_)) {
-            return NULL;
-        }
-        CPyObject py_sensor(py_sensor_, true);
-        auto basicSensor = std::make_unique<PyBasicTempSensor>(py_sensor);
-        auto sensor = std::make_unique<TempSensor>(TEMP_SENSOR_TYPE_BEER, basicSensor.get());
+        std::unique_ptr<BasicTempSensor> basicSensor(parseSetSensorArgs(args, kwds));
+        auto sensor = std::make_unique<TempSensor>(TEMP_SENSOR_TYPE_FRIDGE, basicSensor.get());
 
-        sensor->init();
+        initSensor(*self->refs, *sensor, basicSensor.get());
 
-        self->refs->basicFridgeSensor = std::move(basicSensor);
-        self->refs->fridgeSensor = std::move(sensor);
-        tempControl.fridgeSensor = sensor.get();
+        // swap in under the lock, the old sensor is freed
+        // when these go out of scope, with the GIL held
+        std::unique_ptr<BasicTempSensor> oldBasicSensor(std::move(basicSensor));
+        std::unique_ptr<TempSensor> oldSensor(std::move(sensor));
+        withChamber(self, [&](TempControlRefs &refs) {
+            std::swap(refs.basicFridgeSensor, oldBasicSensor);
+            std::swap(refs.fridgeSensor, oldSensor);
+            refs.controller().fridgeSensor = refs.fridgeSensor.get();
+        });
 
         Py_RETURN_NONE;
     } catch(...) {
@@ -258,16 +271,54 @@ TempControl_setFridgeSensor(TempControl_Object *self, PyObject *args) {
     }
 }
 
+/*
+   Both setHeater and setCooler take a switch and an optional
+   refresh interval in seconds, see PyActuator, or a gpio line
+   given by either path or chip and line, see GpioActuator
+   */
+std::unique_ptr<Actuator> parseSetSwitchArgs(PyObject *args, PyObject *kwds) {
+    PyObject *py_switch_ = NULL;
+    double refresh = 0;
+    const char *path = NULL;
+    const char *chip = NULL;
+    int line = -1;
+    int activeLow = 0;
+    static const char *kwlist[] = {"switch", "refresh", "path", "chip", "line", "activeLow", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O$dssip", (char **) kwlist,
+                &py_switch_, &refresh, &path, &chip, &line, &activeLow)) {
+        throw std::exception();
+    }
+    if((py_switch_ != NULL) + (path != NULL) + (chip != NULL) != 1) {
+        PyErr_SetString(PyExc_RuntimeError, "expected either a switch, a path or a chip");
+        throw std::exception();
+    }
+    if(path != NULL) {
+        return std::make_unique<GpioActuator>(path, activeLow);
+    }
+    if(chip != NULL) {
+        if(line < 0) {
+            PyErr_SetString(PyExc_RuntimeError, "chip needs a line");
+            throw std::exception();
+        }
+        return std::make_unique<GpioActuator>(chip, line, activeLow);
+    }
+    if(refresh < 0) {
+        PyErr_SetString(PyExc_RuntimeError, "refresh must not be negative");
+        throw std::exception();
+    }
+    CPyObject py_switch(py_switch_, true);
+    return std::make_unique<PyActuator>(py_switch, (unsigned long)(refresh * 1000));
+}
+
 static PyObject *
-TempControl_setHeater(TempControl_Object *self, PyObject *args) {
+TempControl_setHeater(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
     try {
-        PyObject *py_switch_;
-        if(!PyArg_ParseTuple(args, "O", &py_switch_)) {
-            return NULL;
-        }
-        CPyObject py_switch(py_switch_, true);
-        self->refs->heater = std::make_unique<PyActuator>(py_switch);
-        tempControl.heater = self->refs->heater.get();
+        std::unique_ptr<Actuator> actuator(parseSetSwitchArgs(args, kwds));
+        withChamber(self, [&](TempControlRefs &refs) {
+            std::swap(refs.heater, actuator);
+            refs.controller().heater = refs.heater.get();
+        });
 
         Py_RETURN_NONE;
     } catch(...) {
@@ -276,15 +327,14 @@ TempControl_setHeater(TempControl_Object *self, PyObject *args) {
 }
 
 static PyObject *
-TempControl_setCooler(TempControl_Object *self, PyObject *args) {
+TempControl_setCooler(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
     try {
-        PyObject *py_switch_;
-        if(!PyArg_ParseTuple(args, "O", &py_switch_)) {
-            return NULL;
-        }
-        CPyObject py_switch(py_switch_, true);
-        self->refs->cooler = std::make_unique<PyActuator>(py_switch);
-        tempControl.cooler = self->refs->cooler.get();
+        std::unique_ptr<Actuator> actuator(parseSetSwitchArgs(args, kwds));
+        withChamber(self, [&](TempControlRefs &refs) {
+            std::swap(refs.cooler, actuator);
+            refs.controller().cooler = refs.cooler.get();
+        });
 
         Py_RETURN_NONE;
     } catch(...) {
@@ -293,13 +343,16 @@ TempControl_setCooler(TempControl_Object *self, PyObject *args) {
 }
 
 static PyObject *
-TempControl_setMode(PyObject *self, PyObject *args) {
+TempControl_setMode(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
         int mode;
         if(!PyArg_ParseTuple(args, "i", &mode)) {
             return NULL;
         }
-        tempControl.setMode(mode);
+        withChamber(self, [mode](TempControlRefs &refs) {
+            refs.controller().setMode(mode);
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
@@ -340,9 +393,12 @@ temperature parseSetTempArgs(TempControl_Object *self, PyObject *args, PyObject
 
 static PyObject *
 TempControl_setBeerTemp(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
     try {
         temperature temp = parseSetTempArgs(self, args, kwds);;
-        tempControl.setBeerTemp(temp);
+        withChamber(self, [temp](TempControlRefs &refs) {
+            refs.controller().setBeerTemp(temp);
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
@@ -351,29 +407,117 @@ TempControl_setBeerTemp(TempControl_Object *self, PyObject *args, PyObject *kwds
 
 static PyObject *
 TempControl_setFridgeTemp(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
     try {                                                        
         temperature temp = parseSetTempArgs(self, args, kwds);
-        tempControl.setFridgeTemp(temp);
+        withChamber(self, [temp](TempControlRefs &refs) {
+            refs.controller().setFridgeTemp(temp);
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
     }
 }
 
+/*
+   python: setProfile(points, step=False, elapsed=0)
+           setProfile(None)
+   points is a sequence of (seconds, beer setting) in the object's
+   unit, sorted by time.  While in MODE_BEER_PROFILE every tick sets
+   the beer setting from the profile, interpolated linearly between
+   points or held until the next point if step.  Profile time starts
+   at the next tick, elapsed seconds into the profile.  None removes
+   the profile.
+   */
 static PyObject *
-TempControl_reset(PyObject *self, PyObject *args) {
+TempControl_setProfile(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
     try {
-        tempControl.reset();
+        PyObject *py_points;
+        int step = 0;
+        double elapsed = 0;
+        static const char *kwlist[] = {"points", "step", "elapsed", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|pd", (char **) kwlist, &py_points, &step, &elapsed)) {
+            return NULL;
+        }
+        std::unique_ptr<TempProfile> profile;
+        if(py_points != Py_None) {
+            CPyObject seq(PySequence_Fast(py_points, "points must be a sequence"));
+            Py_ssize_t n = PySequence_Fast_GET_SIZE((PyObject *) seq);
+            if(n == 0) {
+                PyErr_SetString(PyExc_ValueError, "profile has no points");
+                return NULL;
+            }
+            if(!(elapsed >= 0)) {
+                PyErr_SetString(PyExc_ValueError, "elapsed must not be negative");
+                return NULL;
+            }
+            std::vector<ProfilePoint> points;
+            for(Py_ssize_t i = 0; i < n; i++) {
+                double time;
+                PyObject *temp;
+                if(!PyArg_ParseTuple(PySequence_Fast_GET_ITEM((PyObject *) seq, i), "dO", &time, &temp)) {
+                    return NULL;
+                }
+                if(!(time >= 0) || (!points.empty() && time * 1000 < points.back().time)) {
+                    PyErr_SetString(PyExc_ValueError, "profile times must be sorted and not negative");
+                    return NULL;
+                }
+                points.push_back({(unsigned long) (time * 1000), pyNumToTemp(self->unit, temp)});
+            }
+            profile.reset(new TempProfile(points, step, elapsed * 1000));
+        }
+        withChamber(self, [&profile](TempControlRefs &refs) {
+            std::swap(refs.profile, profile);
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
     }
 }
 
+/*
+   python: getProfile() -> None or {points, step, elapsed}
+   as given to setProfile, with elapsed as of the last tick, so
+   a restarted process can pick the profile up where it was
+   */
+static PyObject *
+TempControl_getProfile(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    try {
+        std::unique_ptr<TempProfile> profile;
+        withChamber(self, [&profile](TempControlRefs &refs) {
+            if(refs.profile) {
+                profile.reset(new TempProfile(*refs.profile));
+            }
+        });
+        if(!profile) {
+            Py_RETURN_NONE;
+        }
+        CPyObject points(PyList_New(0));
+        for(const ProfilePoint &p : profile->points) {
+            CPyObject temp(tempToPyFloat(self->unit, p.temp));
+            CPyObject point(Py_BuildValue("(dO)", p.time / 1000.0, (PyObject *) temp));
+            if(PyList_Append(points, point) < 0) {
+                return NULL;
+            }
+        }
+        return Py_BuildValue("{s:O,s:O,s:d}",
+                "points", (PyObject *) points,
+                "step", profile->step ? Py_True : Py_False,
+                "elapsed", profile->elapsed() / 1000.0);
+    } catch(...) {
+        return NULL;
+    }
+}
+
 static PyObject *
-TempControl_loadDefaultSettings(PyObject *self, PyObject *args) {
+TempControl_reset(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        tempControl.loadDefaultSettings();
+        withChamber(self, [](TempControlRefs &refs) {
+            refs.controller().reset();
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
@@ -381,9 +525,12 @@ TempControl_loadDefaultSettings(PyObject *self, PyObject *args) {
 }
 
 static PyObject *
-TempControl_loadDefaultConstants(PyObject *self, PyObject *args) {
+TempControl_loadDefaultSettings(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        tempControl.loadDefaultConstants();
+        withChamber(self, [](TempControlRefs &refs) {
+            refs.controller().loadDefaultSettings();
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
@@ -391,59 +538,141 @@ TempControl_loadDefaultConstants(PyObject *self, PyObject *args) {
 }
 
 static PyObject *
-TempControl_updateTemperatures(PyObject *self, PyObject *args) {
+TempControl_loadDefaultConstants(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        tempControl.updateTemperatures();
+        withChamber(self, [](TempControlRefs &refs) {
+            refs.controller().loadDefaultConstants();
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
     }
 }
 
+/*
+   What save writes to the eeprom: the sizes of the structs
+   (so an image from an incompatible build is not loaded),
+   then ControlSettings, then ControlConstants
+   */
+struct EepromLayout {
+    uint16_t settingsSize;
+    uint16_t constantsSize;
+};
+
+#define EEPROM_SETTINGS_OFFSET sizeof(EepromLayout)
+#define EEPROM_CONSTANTS_OFFSET (EEPROM_SETTINGS_OFFSET + sizeof(ControlSettings))
+
+/*
+   python: setEeprom(path, size=1024)
+   */
 static PyObject *
-TempControl_detectPeaks(PyObject *self, PyObject *args) {
+TempControl_setEeprom(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
     try {
-        tempControl.detectPeaks();
+        const char *path;
+        Py_ssize_t size = EEPROM_DEFAULT_SIZE;
+        static const char *kwlist[] = {"path", "size", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|n", (char **) kwlist, &path, &size)) {
+            return NULL;
+        }
+        if(size < (Py_ssize_t) (EEPROM_CONSTANTS_OFFSET + sizeof(ControlConstants))) {
+            PyErr_SetString(PyExc_RuntimeError, "eeprom too small");
+            return NULL;
+        }
+        std::unique_ptr<Eeprom> eeprom(new Eeprom(path, size));
+        withChamber(self, [&](TempControlRefs &refs) {
+            std::swap(refs.eeprom, eeprom);
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
     }
 }
 
+/*
+   python: save()
+   stores the control settings and constants in the eeprom
+   */
 static PyObject *
-TempControl_updatePID(PyObject *self, PyObject *args) {
+TempControl_save(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        tempControl.updatePID();
+        withChamber(self, [](TempControlRefs &refs) {
+            EepromScope scope(refs.eeprom.get());
+            EepromLayout layout = {sizeof(ControlSettings), sizeof(ControlConstants)};
+            eeprom_update_block(&layout, (void *) 0, sizeof(layout));
+            refs.controller().storeSettings(EEPROM_SETTINGS_OFFSET);
+            refs.controller().storeConstants(EEPROM_CONSTANTS_OFFSET);
+            refs.eeprom->commit();
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
     }
 }
 
+/*
+   python: load() -> bool
+   restores what save stored, False if the eeprom holds nothing
+   usable, in which case the defaults have to be loaded instead
+   */
 static PyObject *
-TempControl_getState(PyObject *self, PyObject *args) {
+TempControl_load(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        unsigned char state = tempControl.getState();
-        return PyLong_FromLong(state);
+        bool loaded = withChamber(self, [](TempControlRefs &refs) {
+            EepromScope scope(refs.eeprom.get());
+            EepromLayout layout;
+            eeprom_read_block(&layout, (void *) 0, sizeof(layout));
+            if(!refs.eeprom->loaded() || layout.settingsSize != sizeof(ControlSettings)
+                    || layout.constantsSize != sizeof(ControlConstants)) {
+                return false;
+            }
+            refs.controller().loadSettings(EEPROM_SETTINGS_OFFSET);
+            refs.controller().loadConstants(EEPROM_CONSTANTS_OFFSET);
+            return true;
+        });
+        return PyBool_FromLong(loaded);
     } catch(...) {
         return NULL;
     }
 }
 
+/*
+   python: snapshot() -> bytes
+   the running state of the controller, its switches and profile,
+   see snapshot.h
+   */
 static PyObject *
-TempControl_updateState(PyObject *self, PyObject *args) {
+TempControl_snapshot(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        tempControl.updateState();
-        Py_RETURN_NONE;
+        std::string blob = withChamber(self, [](TempControlRefs &refs) {
+            return snapshotChamber(refs);
+        });
+        return PyBytes_FromStringAndSize(blob.data(), blob.size());
     } catch(...) {
         return NULL;
     }
 }
 
+/*
+   python: restore(snapshot)
+   */
 static PyObject *
-TempControl_updateOutputs(PyObject *self, PyObject *args) {
+TempControl_restore(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        tempControl.updateOutputs();
+        Py_buffer view;
+        if(!PyArg_ParseTuple(args, "y*", &view)) {
+            return NULL;
+        }
+        std::string blob((const char *) view.buf, view.len);
+        PyBuffer_Release(&view);
+        withChamber(self, [&](TempControlRefs &refs) {
+            restoreChamber(refs, blob);
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
@@ -451,9 +680,12 @@ TempControl_updateOutputs(PyObject *self, PyObject *args) {
 }
 
 static PyObject *
-TempControl_initFilters(PyObject *self, PyObject *args) {
+TempControl_updateTemperatures(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        tempControl.initFilters();
+        withChamber(self, [](TempControlRefs &refs) {
+            refs.controller().updateTemperatures();
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
@@ -461,22 +693,12 @@ TempControl_initFilters(PyObject *self, PyObject *args) {
 }
 
 static PyObject *
-TempControl_setControlSettings(TempControl_Object *self, PyObject *args) {
+TempControl_detectPeaks(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        PyObject *cs;
-        if(!PyArg_ParseTuple(args, "O", &cs)) {
-            return NULL;
-        }
-        if(!PyDict_Check(cs)) {
-            PyErr_SetString(PyExc_RuntimeError, "dictionary expected");
-            return NULL;
-        }
-        char unit = unit;
-        tempControl.cs.mode = pyNumToLong(getFromDict(cs, "mode"));
-        tempControl.cs.beerSetting = pyNumToTemp(unit, getFromDict(cs, "beerSetting"));
-        tempControl.cs.fridgeSetting = pyNumToTemp(unit, getFromDict(cs, "fridgeSettings"));
-        tempControl.cs.heatEstimator = pyNumToTempDiff(unit, getFromDict(cs, "heatEstimator"));
-        tempControl.cs.coolEstimator = pyNumToTempDiff(unit, getFromDict(cs, "coolEstimator"));
+        withChamber(self, [](TempControlRefs &refs) {
+            refs.controller().detectPeaks();
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
@@ -484,28 +706,12 @@ TempControl_setControlSettings(TempControl_Object *self, PyObject *args) {
 }
 
 static PyObject *
-TempControl_setControlVariables(TempControl_Object *self, PyObject *args) {
+TempControl_updatePID(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        PyObject *cv;
-        if(!PyArg_ParseTuple(args, "O", &cv)) {
-            return NULL;
-        }
-        if(!PyDict_Check(cv)) {
-            PyErr_SetString(PyExc_RuntimeError, "dictionary expected");
-            return NULL;
-        }
-        char unit = unit;
-        tempControl.cv.beerDiff = pyNumToTempDiff(unit, getFromDict(cv, "beerDiff"));
-        tempControl.cv.diffIntegral = pyNumToTempDiff(unit, getFromDict(cv, "diffIntegral"));
-        tempControl.cv.beerSlope = pyNumToTempDiff(unit, getFromDict(cv, "beerSlope"));
-        tempControl.cv.p = pyNumToTempDiff(unit, getFromDict(cv, "p"));
-        tempControl.cv.i = pyNumToTempDiff(unit, getFromDict(cv, "i"));
-        tempControl.cv.d = pyNumToTempDiff(unit, getFromDict(cv, "d"));
-        tempControl.cv.estimatedPeak = pyNumToTempDiff(unit, getFromDict(cv, "estimatedPeak"));
-        tempControl.cv.negPeakEstimate = pyNumToTempDiff(unit, getFromDict(cv, "negPeakEstimate"));
-        tempControl.cv.posPeakEstimate = pyNumToTempDiff(unit, getFromDict(cv, "posPeakEstimate"));
-        tempControl.cv.negPeak = pyNumToTempDiff(unit, getFromDict(cv, "negPeak"));
-        tempControl.cv.posPeak = pyNumToTempDiff(unit, getFromDict(cv, "posPeak"));
+        withChamber(self, [](TempControlRefs &refs) {
+            refs.controller().updatePID();
+        });
         Py_RETURN_NONE;
     } catch(...) {
         return NULL;
@@ -513,174 +719,2392 @@ TempControl_setControlVariables(TempControl_Object *self, PyObject *args) {
 }
 
 static PyObject *
-TempControl_getControlSettings(TempControl_Object *self, PyObject *args) {
+TempControl_getState(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        CPyObject d(PyDict_New());
-        char unit = self->unit;
-        PyDict_SetItemString(d, "mode", CPyObject(PyLong_FromLong(tempControl.cs.mode)));
-        PyDict_SetItemString(d, "beerSetting", tempToPyFloat(unit, tempControl.cs.beerSetting));
-        PyDict_SetItemString(d, "fridgeSetting", tempToPyFloat(unit, tempControl.cs.fridgeSetting));
-        PyDict_SetItemString(d, "heatEstimator", tempDiffToPyFloat(unit, tempControl.cs.heatEstimator));
-        PyDict_SetItemString(d, "coolEstimator", tempDiffToPyFloat(unit, tempControl.cs.coolEstimator));
-        return d.release();
+        unsigned char state = withChamber(self, [](TempControlRefs &refs) {
+            return refs.controller().getState();
+        });
+        return PyLong_FromLong(state);
     } catch(...) {
         return NULL;
     }
 }
 
 static PyObject *
-TempControl_getControlVariables(TempControl_Object *self, PyObject *args) {
+TempControl_updateState(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        CPyObject d(PyDict_New());
-        char unit = self->unit;
-        PyDict_SetItemString(d, "beerDiff", tempDiffToPyFloat(unit, tempControl.cv.beerDiff));
-        PyDict_SetItemString(d, "diffIntegral", tempDiffToPyFloat(unit, tempControl.cv.diffIntegral));
-        PyDict_SetItemString(d, "beerSlope", tempDiffToPyFloat(unit, tempControl.cv.beerSlope));
-        PyDict_SetItemString(d, "p", tempDiffToPyFloat(unit, tempControl.cv.p));
-        PyDict_SetItemString(d, "i", tempDiffToPyFloat(unit, tempControl.cv.i));
-        PyDict_SetItemString(d, "d", tempDiffToPyFloat(unit, tempControl.cv.d));
-        PyDict_SetItemString(d, "estimatedPeak", tempDiffToPyFloat(unit, tempControl.cv.estimatedPeak));
-        PyDict_SetItemString(d, "negPeakEstimate", tempDiffToPyFloat(unit, tempControl.cv.negPeakEstimate));
-        PyDict_SetItemString(d, "posPeakEstimate", tempDiffToPyFloat(unit, tempControl.cv.posPeakEstimate));
-        PyDict_SetItemString(d, "negPeak", tempDiffToPyFloat(unit, tempControl.cv.negPeak));
-        PyDict_SetItemString(d, "posPeak", tempDiffToPyFloat(unit, tempControl.cv.posPeak));
-        return d.release();
+        withChamber(self, [](TempControlRefs &refs) {
+            refs.controller().updateState();
+        });
+        Py_RETURN_NONE;
     } catch(...) {
         return NULL;
     }
 }
 
 static PyObject *
-TempControl_getControlConstants(TempControl_Object *self, PyObject *args) {
+TempControl_updateOutputs(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
     try {
-        CPyObject d(PyDict_New());
-        char unit = self->unit;
-        PyDict_SetItemString(d, "tempFormats", CPyObject(PyLong_FromLong(tempControl.cc.tempFormat)));
-        PyDict_SetItemString(d, "tempSettingMin", tempToPyFloat(unit, tempControl.cc.tempSettingMin));
-        PyDict_SetItemString(d, "tempSettingMax", tempToPyFloat(unit, tempControl.cc.tempSettingMax));
-        PyDict_SetItemString(d, "Kp", tempDiffToPyFloat(unit, tempControl.cc.Kp));
-        PyDict_SetItemString(d, "Ki", tempDiffToPyFloat(unit, tempControl.cc.Ki));
-        PyDict_SetItemString(d, "Kd", tempDiffToPyFloat(unit, tempControl.cc.Kd));
-        PyDict_SetItemString(d, "iMaxError", tempDiffToPyFloat(unit, tempControl.cc.iMaxError));
-        PyDict_SetItemString(d, "idleRangeHigh", tempDiffToPyFloat(unit, tempControl.cc.idleRangeHigh));
-        PyDict_SetItemString(d, "idleRangeLow", tempDiffToPyFloat(unit, tempControl.cc.idleRangeLow));
-        PyDict_SetItemString(d, "heatingTargetUpper", tempDiffToPyFloat(unit, tempControl.cc.heatingTargetUpper));
-        PyDict_SetItemString(d, "heatingTargetLower", tempDiffToPyFloat(unit, tempControl.cc.heatingTargetLower));
-        PyDict_SetItemString(d, "coolingTargetUpper", tempDiffToPyFloat(unit, tempControl.cc.coolingTargetUpper));
-        PyDict_SetItemString(d, "coolingTargetLower", tempDiffToPyFloat(unit, tempControl.cc.coolingTargetLower));
-        PyDict_SetItemString(d, "maxHeatTimeForEstimate", CPyObject(PyLong_FromLong(tempControl.cc.maxHeatTimeForEstimate)));
-        PyDict_SetItemString(d, "maxCoolTimeForEstimate", CPyObject(PyLong_FromLong(tempControl.cc.maxCoolTimeForEstimate)));
-        PyDict_SetItemString(d, "fridgeFastFilter", CPyObject(PyLong_FromLong(tempControl.cc.fridgeFastFilter)));
-        PyDict_SetItemString(d, "fridgeSlowFilter", CPyObject(PyLong_FromLong(tempControl.cc.fridgeSlowFilter)));
-        PyDict_SetItemString(d, "fridgeSlopeFilter", CPyObject(PyLong_FromLong(tempControl.cc.fridgeSlopeFilter)));
-        PyDict_SetItemString(d, "beerFastFilter", CPyObject(PyLong_FromLong(tempControl.cc.beerFastFilter)));
-        PyDict_SetItemString(d, "beerSlowFilter", CPyObject(PyLong_FromLong(tempControl.cc.beerSlowFilter)));
-        PyDict_SetItemString(d, "beerSlopeFilter", CPyObject(PyLong_FromLong(tempControl.cc.beerSlopeFilter)));
-        PyDict_SetItemString(d, "lightAsHeater", CPyObject(PyLong_FromLong(tempControl.cc.lightAsHeater)));
-        PyDict_SetItemString(d, "rotaryHalfSteps", CPyObject(PyLong_FromLong(tempControl.cc.rotaryHalfSteps)));
-        PyDict_SetItemString(d, "pidMax", tempDiffToPyFloat(unit, tempControl.cc.pidMax));
-        return d.release();
+        withChamber(self, [](TempControlRefs &refs) {
+            refs.controller().updateOutputs();
+        });
+        Py_RETURN_NONE;
     } catch(...) {
         return NULL;
     }
 }
 
-static PyMethodDef TempControl_Methods[] = {
-    {"init", TempControl_init, METH_NOARGS, NULL},
-    {"reset", TempControl_reset, METH_NOARGS, NULL},
-    {"updateTemperatures", TempControl_updateTemperatures, METH_NOARGS, NULL},
-    {"updatePID", TempControl_updatePID, METH_NOARGS, NULL},
-    {"getState", TempControl_getState, METH_NOARGS, NULL},
-    {"updateState", TempControl_updateState, METH_NOARGS, NULL},
-    {"updateOutputs", TempControl_updateOutputs, METH_NOARGS, NULL},
-    {"detectPeaks", TempControl_detectPeaks, METH_NOARGS, NULL},
-    {"loadDefaultSettings", TempControl_loadDefaultSettings, METH_NOARGS, NULL},
-    {"loadDefaultConstants", TempControl_loadDefaultConstants, METH_NOARGS, NULL},
-    {"setBeerTemp", (PyCFunction) TempControl_setBeerTemp, METH_VARARGS | METH_KEYWORDS, NULL},
-    {"setFridgeTemp", (PyCFunction) TempControl_setFridgeTemp, METH_VARARGS | METH_KEYWORDS, NULL},
-    {"setMode", TempControl_setMode, METH_VARARGS, NULL},
-    {"setBeerSensor", (PyCFunction) TempControl_setBeerSensor, METH_VARARGS, NULL},
-    {"setFridgeSensor", (PyCFunction) TempControl_setFridgeSensor, METH_VARARGS, NULL},
-    {"setHeater", (PyCFunction) TempControl_setHeater, METH_VARARGS, NULL},
-    {"setCooler", (PyCFunction) TempControl_setCooler, METH_VARARGS, NULL},
-    {"initFilters", (PyCFunction) TempControl_initFilters, METH_NOARGS, NULL},
-    {"getControlSettings", (PyCFunction) TempControl_getControlSettings, METH_NOARGS, NULL},
-    {"setControlSettings", (PyCFunction) TempControl_setControlSettings, METH_VARARGS, NULL},
-    {"getControlVariables", (PyCFunction) TempControl_getControlVariables, METH_NOARGS, NULL},
-    {"setControlVariables", (PyCFunction) TempControl_setControlVariables, METH_VARARGS, NULL},
-    {"getControlConstants", (PyCFunction) TempControl_getControlConstants, METH_NOARGS, NULL},
-    {NULL, NULL, 0, NULL}        /* Sentinel */
-};
+static PyObject *
+tickResultToPy(const TickResult &r) {
+    return Py_BuildValue("(iiO)", r.oldState, r.newState,
+            r.oldState != r.newState ? Py_True : Py_False);
+}
 
-static PyTypeObject TempControl_Type = {
-    PyVarObject_HEAD_INIT(NULL, 0)
-    "TempControl.TempControl",             /* tp_name */
-    sizeof(TempControl_Object), /* tp_basicsize */
-    0,                         /* tp_itemsize */
-    (destructor) TempControl_dealloc__,     /* tp_dealloc */
-    0,                         /* tp_print */
-    0,                         /* tp_getattr */
-    0,                         /* tp_setattr */
-    0,                         /* tp_reserved */
-    0,                         /* tp_repr */
-    0,                         /* tp_as_number */
-    0,                         /* tp_as_sequence */
-    0,                         /* tp_as_mapping */
-    0,                         /* tp_hash  */
-    0,                         /* tp_call */
-    0,                         /* tp_str */
-    0,                         /* tp_getattro */
-    0,                         /* tp_setattro */
-    0,                         /* tp_as_buffer */
-    Py_TPFLAGS_DEFAULT,        /* tp_flags */
-    "TempControl",           /* tp_doc */
-    0,                         /* tp_traverse */
-    0,                         /* tp_clear */
-    0,                         /* tp_richcompare */
-    0,                         /* tp_weaklistoffset */
-    0,                         /* tp_iter */
-    0,                         /* tp_iternext */
-    TempControl_Methods,             /* tp_methods */
-    0,             /* tp_members */
-    0,                         /* tp_getset */
-    0,                         /* tp_base */
-    0,                         /* tp_dict */
-    0,                         /* tp_descr_get */
-    0,                         /* tp_descr_set */
-    0,                         /* tp_dictoffset */
-    (initproc) TempControl_init__,      /* tp_init */
-    0,                         /* tp_alloc */
-    TempControl_new__,                 /* tp_new */
-};
+// true if a sensor or switch of refs is async, which only tickAsync can drive
+static bool
+hasAsyncIO(TempControlRefs &refs) {
+    for(BasicTempSensor *b : {refs.basicBeerSensor.get(), refs.basicFridgeSensor.get()}) {
+        PyBasicTempSensor *sensor = dynamic_cast<PyBasicTempSensor *>(b);
+        if(sensor != nullptr && sensor->isAsync()) {
+            return true;
+        }
+    }
+    for(Actuator *a : {refs.heater.get(), refs.cooler.get()}) {
+        PyActuator *actuator = dynamic_cast<PyActuator *>(a);
+        if(actuator != nullptr && actuator->isAsync()) {
+            return true;
+        }
+    }
+    return false;
+}
 
-static struct PyModuleDef TempControl_Module = {
-    PyModuleDef_HEAD_INIT,
-    "TempControl",   /* name of module */
-    NULL, /* module documentation, may be NULL */
-    -1,       /* size of per-interpreter state of the module,
-                 or -1 if the module keeps state in global variables. */
-    NULL //TempControlMethods
-};
+static void
+asyncIOError() {
+    PyErr_SetString(PyExc_ValueError, "async sensors and switches need tickAsync");
+    throw std::exception();
+}
 
-PyMODINIT_FUNC
-PyInit_TempControl(void)
-{
-    PyObject *module = PyModule_Create(&TempControl_Module);
-    if(module == NULL) {
-        return NULL;
+// throws ValueError if a sensor or switch of self is async
+static void
+checkSyncIO(TempControl_Object *self) {
+    if(withChamber(self, hasAsyncIO)) {
+        asyncIOError();
     }
+}
 
-    if (PyType_Ready(&TempControl_Type) < 0)
+/*
+   python: tick() -> (oldState, newState, changed)
+   */
+static PyObject *
+TempControl_tick(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    try {
+        TickResult r = withChamber(self, [](TempControlRefs &refs) {
+            if(hasAsyncIO(refs)) {
+                GILAcquire gil;
+                asyncIOError();
+            }
+            return refs.tick();
+        });
+        return tickResultToPy(r);
+    } catch(...) {
         return NULL;
-    Py_INCREF(&TempControl_Type);
+    }
+}
+
+/*
+   One control cycle of refs as a scheduler thread runs it, a
+   python exception is printed and rethrown to be counted
+   */
+static std::function<void()>
+chamberCycle(TempControlRefs *refs) {
+    return [refs]() {
+        ChamberLock guard(*refs);
+        try {
+            refs->tick();
+        } catch(...) {
+            GILAcquire gil;
+            if(PyErr_Occurred()) {
+                PyErr_WriteUnraisable(NULL);
+            }
+            throw;
+        }
+    };
+}
+
+static bool
+parsePeriod(double period, uint64_t *ns) {
+    if(!(period >= 0.001 && period < 1e6)) {
+        PyErr_SetString(PyExc_ValueError, "period must be between 0.001 and 1e6 seconds");
+        return false;
+    }
+    *ns = period * 1e9;
+    return true;
+}
+
+/*
+   python: startScheduler(period=1.0)
+   runs the control cycle every period seconds on a native thread
+   until stopScheduler(), python is only called for the sensor
+   reads and switch writes.  An exception from a sensor or switch
+   is printed and counted in schedulerStats, the next cycle runs
+   anyway.  Async sensors and switches need tickAsync instead.
+   */
+static PyObject *
+TempControl_startScheduler(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
+    try {
+        double period = 1.0;
+        static const char *kwlist[] = {"period", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|d", (char **) kwlist, &period)) {
+            return NULL;
+        }
+        if(self->scheduler != NULL || self->wheel != NULL) {
+            PyErr_SetString(PyExc_RuntimeError, "scheduler already running");
+            return NULL;
+        }
+        uint64_t ns;
+        if(!parsePeriod(period, &ns)) {
+            return NULL;
+        }
+        checkSyncIO(self);
+        std::function<void()> cycle = chamberCycle(self->refs);
+        self->scheduler = new TickThread([cycle](uint64_t number) {
+            cycle();
+        }, ns);
+        runningSchedulers.push_back(self);
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   python: stopScheduler()
+   returns once a running cycle has finished
+   */
+static PyObject *
+TempControl_stopScheduler(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    stopScheduler(self);
+    Py_RETURN_NONE;
+}
+
+// {count, min, max, mean, p50, p90, p99}, times in microseconds
+static PyObject *
+stageStatsToPy(const StageStats &s) {
+    uint64_t count = s.count.load();
+    return Py_BuildValue("{s:K,s:d,s:d,s:d,s:d,s:d,s:d}",
+            "count", (unsigned long long) count,
+            "min", count != 0 ? s.min.load() / 1000.0 : 0.0,
+            "max", s.max.load() / 1000.0,
+            "mean", count != 0 ? s.sum.load() / 1000.0 / count : 0.0,
+            "p50", s.percentile(0.5) / 1000.0,
+            "p90", s.percentile(0.9) / 1000.0,
+            "p99", s.percentile(0.99) / 1000.0);
+}
+
+// {running, period, ticks, misses, errors, latency, duration} of a running thread
+static PyObject *
+tickThreadStatsToPy(TickThread *thread, double period, uint64_t errors, bool reset) {
+    CPyObject latency(stageStatsToPy(thread->latency));
+    CPyObject duration(stageStatsToPy(thread->duration));
+    CPyObject stats(Py_BuildValue("{s:O,s:d,s:K,s:K,s:K,s:O,s:O}",
+            "running", Py_True,
+            "period", period,
+            "ticks", (unsigned long long) thread->ticks.load(),
+            "misses", (unsigned long long) thread->misses.load(),
+            "errors", (unsigned long long) errors,
+            "latency", (PyObject *) latency,
+            "duration", (PyObject *) duration));
+    if(reset) {
+        thread->resetStats();
+    }
+    return stats.release();
+}
+
+/*
+   python: schedulerStats(reset=False) -> {running, period, ticks, misses, errors, latency, duration}
+   misses counts deadlines skipped because a cycle overran them,
+   latency is how late the thread woke for a deadline and duration
+   how long the cycle took, both as in getStats.
+   */
+static PyObject *
+TempControl_schedulerStats(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
+    try {
+        int reset = 0;
+        static const char *kwlist[] = {"reset", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", (char **) kwlist, &reset)) {
+            return NULL;
+        }
+        TickThread *scheduler = self->scheduler;
+        if(scheduler == NULL) {
+            return Py_BuildValue("{s:O}", "running", Py_False);
+        }
+        return tickThreadStatsToPy(scheduler, scheduler->period / 1e9, scheduler->errors.load(), reset);
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   TickAwaitable is what tickAsync returns.  Awaiting it
+
+     1. awaits read() of every async sensor together
+     2. runs the same cycle as tick() natively, async sensors
+        return what was just read, async switches only record
+        their writes
+     3. awaits the recorded on()/off() writes together, and
+        only then counts the switches as switched
+
+   and then evaluates to the same tuple as tick().  Plain
+   sensors and switches are called from step 2 as usual.
+   */
+enum TickPhase {
+    TICK_START,
+    TICK_READING,
+    TICK_WRITING,
+    TICK_DONE
+};
+
+typedef struct {
+    PyObject_HEAD
+    TempControl_Object *owner;
+    TickPhase phase;
+    // future of what is being awaited, and its __await__ iterator
+    PyObject *future;
+    PyObject *iter;
+    // the python sensors being read, in the order of the reads
+    PyObject *sensors;
+    PyObject *result;
+} TickAwaitable_Object;
+
+/*
+   The future and the sensors can lead back to the awaitable (a
+   sensor keeping the task that awaits it, say), so it takes part
+   in garbage collection
+   */
+static int
+TickAwaitable_traverse(TickAwaitable_Object *self, visitproc visit, void *arg) {
+    Py_VISIT(self->owner);
+    Py_VISIT(self->future);
+    Py_VISIT(self->iter);
+    Py_VISIT(self->sensors);
+    Py_VISIT(self->result);
+    return 0;
+}
+
+// owner stays, it can't be part of a cycle and the methods rely on it
+static int
+TickAwaitable_clear(TickAwaitable_Object *self) {
+    self->phase = TICK_DONE;
+    Py_CLEAR(self->future);
+    Py_CLEAR(self->iter);
+    Py_CLEAR(self->sensors);
+    Py_CLEAR(self->result);
+    return 0;
+}
+
+static void
+TickAwaitable_dealloc__(TickAwaitable_Object *self) {
+    PyObject_GC_UnTrack(self);
+    TickAwaitable_clear(self);
+    Py_XDECREF(self->owner);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+/*
+   Starts awaiting all of coros together, returns false if
+   there is nothing to await
+   */
+static bool
+TickAwaitable_awaitAll(TickAwaitable_Object *self, std::vector<CPyObject> &coros) {
+    if(coros.empty()) {
+        return false;
+    }
+    static PyObject *gather = nullptr;
+    if(gather == nullptr) {
+        CPyObject asyncio(PyImport_ImportModule("asyncio"));
+        gather = PyObject_GetAttrString(asyncio, "gather");
+        if(gather == nullptr) {
+            throw std::exception();
+        }
+    }
+    CPyObject args(PyTuple_New(coros.size()));
+    for(size_t n = 0; n < coros.size(); n++) {
+        PyTuple_SET_ITEM((PyObject *) args, n, coros[n].release());
+    }
+    CPyObject future(PyObject_Call(gather, args, NULL));
+    CPyObject iter(PyObject_CallMethod(future, "__await__", NULL));
+    self->future = future.release();
+    self->iter = iter.release();
+    return true;
+}
+
+static void
+TickAwaitable_startReads(TickAwaitable_Object *self) {
+    std::vector<CPyObject> coros;
+    CPyObject sensors(PyList_New(0));
+    withChamber(self->owner, [&](TempControlRefs &refs) {
+        GILAcquire gil;
+        for(BasicTempSensor *b : {refs.basicBeerSensor.get(), refs.basicFridgeSensor.get()}) {
+            PyBasicTempSensor *sensor = dynamic_cast<PyBasicTempSensor *>(b);
+            if(sensor != nullptr && sensor->isAsync()) {
+                coros.emplace_back(sensor->callRead());
+                if(PyList_Append(sensors, sensor->pyObject()) < 0) {
+                    throw std::exception();
+                }
+            }
+        }
+    });
+    self->sensors = sensors.release();
+    TickAwaitable_awaitAll(self, coros);
+}
+
+static void
+TickAwaitable_runCycle(TickAwaitable_Object *self, PyObject *values) {
+    std::vector<CPyObject> coros;
+    TickResult r = withChamber(self->owner, [&](TempControlRefs &refs) {
+        {
+            GILAcquire gil;
+            // feed the reads to the sensors, unless one was replaced while awaiting
+            for(Py_ssize_t n = 0; values != nullptr && n < PyList_GET_SIZE(self->sensors); n++) {
+                PyObject *py_sensor = PyList_GET_ITEM(self->sensors, n);
+                temperature temp = PyBasicTempSensor::toTemp(PySequence_Fast_GET_ITEM(values, n));
+                PyBasicTempSensor *beer = dynamic_cast<PyBasicTempSensor *>(refs.basicBeerSensor.get());
+                PyBasicTempSensor *fridge = dynamic_cast<PyBasicTempSensor *>(refs.basicFridgeSensor.get());
+                // init() read nothing from a fresh async sensor, so its filters start here
+                if(beer != nullptr && beer->pyObject() == py_sensor && beer->feed(temp)) {
+                    refs.beerSensor->init();
+                }
+                if(fridge != nullptr && fridge->pyObject() == py_sensor && fridge->feed(temp)) {
+                    refs.fridgeSensor->init();
+                }
+            }
+        }
+        TickResult r = refs.tick();
+        GILAcquire gil;
+        for(Actuator *a : {refs.heater.get(), refs.cooler.get()}) {
+            PyActuator *actuator = dynamic_cast<PyActuator *>(a);
+            if(actuator != nullptr) {
+                PyObject *coro = actuator->takePending();
+                if(coro != NULL) {
+                    coros.emplace_back(coro);
+                }
+            }
+        }
+        return r;
+    });
+    self->result = tickResultToPy(r);
+    if(self->result == NULL) {
+        throw std::exception();
+    }
+    TickAwaitable_awaitAll(self, coros);
+}
+
+// the switch writes runCycle started have all completed
+static void
+TickAwaitable_writesDone(TickAwaitable_Object *self) {
+    withChamber(self->owner, [](TempControlRefs &refs) {
+        for(Actuator *a : {refs.heater.get(), refs.cooler.get()}) {
+            PyActuator *actuator = dynamic_cast<PyActuator *>(a);
+            if(actuator != nullptr) {
+                actuator->writeDone();
+            }
+        }
+    });
+}
+
+/*
+   Value of the StopIteration that ended an __await__
+   iterator, rethrows anything else
+   */
+static CPyObject
+fetchStopIterationValue() {
+    if(!PyErr_Occurred()) {
+        return CPyObject(Py_None, true);
+    }
+    if(!PyErr_ExceptionMatches(PyExc_StopIteration)) {
+        throw std::exception();
+    }
+    PyObject *type, *value, *tb;
+    PyErr_Fetch(&type, &value, &tb);
+    PyErr_NormalizeException(&type, &value, &tb);
+    CPyObject stop(value);
+    Py_XDECREF(type);
+    Py_XDECREF(tb);
+    return CPyObject(PyObject_GetAttrString(stop, "value"));
+}
+
+static PyObject *
+TickAwaitable_next(TickAwaitable_Object *self) {
+    try {
+        while(self->phase != TICK_DONE) {
+            CPyObject value;
+            if(self->iter != NULL) {
+                PyObject *yielded = Py_TYPE(self->iter)->tp_iternext(self->iter);
+                if(yielded != NULL) {
+                    return yielded;
+                }
+                value = fetchStopIterationValue();
+                Py_CLEAR(self->iter);
+                Py_CLEAR(self->future);
+            }
+            switch(self->phase) {
+                case TICK_START:
+                    self->phase = TICK_READING;
+                    TickAwaitable_startReads(self);
+                    break;
+                case TICK_READING:
+                    self->phase = TICK_WRITING;
+                    TickAwaitable_runCycle(self, value);
+                    break;
+                case TICK_WRITING:
+                    self->phase = TICK_DONE;
+                    TickAwaitable_writesDone(self);
+                    break;
+                default:
+                    self->phase = TICK_DONE;
+                    break;
+            }
+        }
+        if(self->result == NULL) {
+            PyErr_SetString(PyExc_RuntimeError, "tick already awaited");
+            return NULL;
+        }
+        CPyObject stop(PyObject_CallFunctionObjArgs(PyExc_StopIteration, self->result, NULL));
+        Py_CLEAR(self->result);
+        PyErr_SetObject(PyExc_StopIteration, stop);
+        return NULL;
+    } catch(...) {
+        self->phase = TICK_DONE;
+        Py_CLEAR(self->iter);
+        Py_CLEAR(self->future);
+        return NULL;
+    }
+}
+
+static PyObject *
+TickAwaitable_send(TickAwaitable_Object *self, PyObject *value) {
+    return TickAwaitable_next(self);
+}
+
+// done callback of a cancelled gather, nobody else will look at its outcome
+static PyObject *
+retrieveException(PyObject *module, PyObject *future) {
+    PyObject *r = PyObject_CallMethod(future, "exception", NULL);
+    Py_XDECREF(r);
+    PyErr_Clear();
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef retrieveExceptionDef = {"retrieveException", retrieveException, METH_O, NULL};
+
+// cancels the gather being awaited, if any, errors are ignored
+static void
+TickAwaitable_cancel(TickAwaitable_Object *self) {
+    if(self->future == NULL) {
+        return;
+    }
+    PyObject *r = PyObject_CallMethod(self->future, "cancel", NULL);
+    Py_XDECREF(r);
+    PyObject *callback = PyCFunction_New(&retrieveExceptionDef, NULL);
+    if(callback != NULL) {
+        r = PyObject_CallMethod(self->future, "add_done_callback", "O", callback);
+        Py_XDECREF(r);
+        Py_DECREF(callback);
+    }
+    PyErr_Clear();
+}
+
+// cancels whatever is being awaited and raises the exception in the awaiter
+static PyObject *
+TickAwaitable_throw(TickAwaitable_Object *self, PyObject *args) {
+    PyObject *type, *value = NULL, *tb = NULL;
+    if(!PyArg_ParseTuple(args, "O|OO", &type, &value, &tb)) {
+        return NULL;
+    }
+    TickAwaitable_cancel(self);
+    self->phase = TICK_DONE;
+    Py_CLEAR(self->iter);
+    Py_CLEAR(self->future);
+    if(PyExceptionInstance_Check(type)) {
+        PyErr_SetObject((PyObject *) Py_TYPE(type), type);
+    } else {
+        PyErr_SetObject(type, value);
+    }
+    return NULL;
+}
+
+static PyObject *
+TickAwaitable_close(TickAwaitable_Object *self, PyObject *args) {
+    TickAwaitable_cancel(self);
+    self->phase = TICK_DONE;
+    Py_CLEAR(self->iter);
+    Py_CLEAR(self->future);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+TickAwaitable_await(TickAwaitable_Object *self) {
+    Py_INCREF(self);
+    return (PyObject *) self;
+}
+
+static PyAsyncMethods TickAwaitable_AsyncMethods = {
+    (unaryfunc) TickAwaitable_await,     /* am_await */
+    0,                         /* am_aiter */
+    0,                         /* am_anext */
+};
+
+static PyMethodDef TickAwaitable_Methods[] = {
+    {"send", (PyCFunction) TickAwaitable_send, METH_O, NULL},
+    {"throw", (PyCFunction) TickAwaitable_throw, METH_VARARGS, NULL},
+    {"close", (PyCFunction) TickAwaitable_close, METH_NOARGS, NULL},
+    {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+
+static PyTypeObject TickAwaitable_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "TempControl.TickAwaitable",             /* tp_name */
+    sizeof(TickAwaitable_Object), /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor) TickAwaitable_dealloc__,     /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    &TickAwaitable_AsyncMethods,                         /* tp_as_async */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,        /* tp_flags */
+    "awaitable control cycle",           /* tp_doc */
+    (traverseproc) TickAwaitable_traverse,                         /* tp_traverse */
+    (inquiry) TickAwaitable_clear,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    PyObject_SelfIter,                         /* tp_iter */
+    (iternextfunc) TickAwaitable_next,                         /* tp_iternext */
+    TickAwaitable_Methods,             /* tp_methods */
+};
+
+/*
+   python: await tickAsync() -> (oldState, newState, changed)
+   */
+static PyObject *
+TempControl_tickAsync(TempControl_Object *self, PyObject *args) {
+    TickAwaitable_Object *a = PyObject_GC_New(TickAwaitable_Object, &TickAwaitable_Type);
+    if(a == NULL) {
+        return NULL;
+    }
+    Py_INCREF(self);
+    a->owner = self;
+    a->phase = TICK_START;
+    a->future = NULL;
+    a->iter = NULL;
+    a->sensors = NULL;
+    a->result = NULL;
+    PyObject_GC_Track(a);
+    return (PyObject *) a;
+}
+
+static PyObject *
+TempControl_initFilters(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    try {
+        withChamber(self, [](TempControlRefs &refs) {
+            refs.controller().initFilters();
+        });
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyObject *
+TempControl_setControlSettings(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    try {
+        PyObject *cs;
+        if(!PyArg_ParseTuple(args, "O", &cs)) {
+            return NULL;
+        }
+        if(!PyDict_Check(cs)) {
+            PyErr_SetString(PyExc_RuntimeError, "dictionary expected");
+            return NULL;
+        }
+        char unit = self->unit;
+        // every field comes from the dict, converted before the chamber is locked
+        ControlSettings settings = {};
+        settings.mode = pyNumToLong(getFromDict(cs, "mode"));
+        settings.beerSetting = pyNumToTemp(unit, getFromDict(cs, "beerSetting"));
+        settings.fridgeSetting = pyNumToTemp(unit, getFromDict(cs, "fridgeSettings"));
+        settings.heatEstimator = pyNumToTempDiff(unit, getFromDict(cs, "heatEstimator"));
+        settings.coolEstimator = pyNumToTempDiff(unit, getFromDict(cs, "coolEstimator"));
+        withChamber(self, [&settings](TempControlRefs &refs) {
+            refs.controller().cs = settings;
+        });
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyObject *
+TempControl_setControlVariables(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    try {
+        PyObject *cv;
+        if(!PyArg_ParseTuple(args, "O", &cv)) {
+            return NULL;
+        }
+        if(!PyDict_Check(cv)) {
+            PyErr_SetString(PyExc_RuntimeError, "dictionary expected");
+            return NULL;
+        }
+        char unit = self->unit;
+        ControlVariables variables = {};
+        variables.beerDiff = pyNumToTempDiff(unit, getFromDict(cv, "beerDiff"));
+        variables.diffIntegral = pyNumToLongTempDiff(unit, getFromDict(cv, "diffIntegral"));
+        variables.beerSlope = pyNumToTempDiff(unit, getFromDict(cv, "beerSlope"));
+        variables.p = pyNumToLongTempDiff(unit, getFromDict(cv, "p"));
+        variables.i = pyNumToLongTempDiff(unit, getFromDict(cv, "i"));
+        variables.d = pyNumToLongTempDiff(unit, getFromDict(cv, "d"));
+        variables.estimatedPeak = pyNumToTempDiff(unit, getFromDict(cv, "estimatedPeak"));
+        variables.negPeakEstimate = pyNumToTempDiff(unit, getFromDict(cv, "negPeakEstimate"));
+        variables.posPeakEstimate = pyNumToTempDiff(unit, getFromDict(cv, "posPeakEstimate"));
+        variables.negPeak = pyNumToTempDiff(unit, getFromDict(cv, "negPeak"));
+        variables.posPeak = pyNumToTempDiff(unit, getFromDict(cv, "posPeak"));
+        withChamber(self, [&variables](TempControlRefs &refs) {
+            refs.controller().cv = variables;
+        });
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   getControlSettings and getControlConstants hand out read only
+   views of a dict they keep until the struct behind it changes,
+   so polling them costs nothing while nothing changes.  Returns
+   a new reference to the view of d.
+   */
+static PyObject *
+cacheMapping(PyObject **cache, unsigned long *cacheGeneration, PyObject *d, unsigned long generation) {
+    PyObject *proxy = PyDictProxy_New(d);
+    if(proxy == NULL) {
+        throw std::exception();
+    }
+    Py_XDECREF(*cache);
+    Py_INCREF(proxy);
+    *cache = proxy;
+    *cacheGeneration = generation;
+    return proxy;
+}
+
+static PyObject *
+TempControl_getControlSettings(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    try {
+        char unit = self->unit;
+        unsigned long generation;
+        ControlSettings cs = withChamber(self, [&generation](TempControlRefs &refs) {
+            refs.noteChanges();
+            generation = refs.settingsGeneration;
+            return refs.controller().cs;
+        });
+        if(self->settingsCache != NULL && self->settingsCacheGeneration == generation) {
+            Py_INCREF(self->settingsCache);
+            return self->settingsCache;
+        }
+        CPyObject d(PyDict_New());
+        PyDict_SetItemString(d, "mode", CPyObject(PyLong_FromLong(cs.mode)));
+        PyDict_SetItemString(d, "beerSetting", tempToPyFloat(unit, cs.beerSetting));
+        PyDict_SetItemString(d, "fridgeSetting", tempToPyFloat(unit, cs.fridgeSetting));
+        PyDict_SetItemString(d, "heatEstimator", tempDiffToPyFloat(unit, cs.heatEstimator));
+        PyDict_SetItemString(d, "coolEstimator", tempDiffToPyFloat(unit, cs.coolEstimator));
+        return cacheMapping(&self->settingsCache, &self->settingsCacheGeneration, d, generation);
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   python: generation() -> int
+   changes whenever the control settings or constants do, pollers
+   can skip getControlSettings/getControlConstants until it moves
+   */
+static PyObject *
+TempControl_generation(TempControl_Object *self, PyObject *args) {
+    try {
+        unsigned long generation = withChamber(self, [](TempControlRefs &refs) {
+            refs.noteChanges();
+            return refs.generation;
+        });
+        return PyLong_FromUnsignedLong(generation);
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   python: chamberId() -> int
+   the id drainLog tags this chamber's records with
+   */
+static PyObject *
+TempControl_chamberId(TempControl_Object *self, PyObject *args) {
+    return PyLong_FromUnsignedLong(self->refs->id);
+}
+
+/*
+   python: changesSince(token=0) -> (token, dict)
+   the cs, cv, state, heater and cooler fields that changed since
+   the call that returned token, keyed "cs.beerSetting", "cv.p",
+   "state", "heater", ...  Token 0 returns every field, and so does
+   a token this chamber never handed out (from another chamber or
+   process), rather than nothing.  Changes are tracked per tick
+   from the first call on, plus whatever the setters changed since
+   the last tick.
+   */
+static PyObject *
+TempControl_changesSince(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    try {
+        unsigned long token = 0;
+        if(!PyArg_ParseTuple(args, "|k", &token)) {
+            throw std::exception();
+        }
+        struct {
+            unsigned long version;
+            size_t count;
+            unsigned char field[TRACKED_FIELD_MAX];
+            long value[TRACKED_FIELD_MAX];
+        } delta;
+        withChamber(self, [&delta, token](TempControlRefs &refs) {
+            if(!refs.changes) {
+                refs.changes.reset(new ChangeTracker());
+            }
+            ChangeTracker &changes = *refs.changes;
+            changes.update(refs.controller());
+            delta.version = changes.version;
+            delta.count = 0;
+            unsigned long since = token <= changes.version ? token : 0;
+            for(size_t n = 0; n < TRACKED_FIELD_COUNT; n++) {
+                if(changes.changed[n] > since) {
+                    delta.field[delta.count] = n;
+                    delta.value[delta.count] = changes.values[n];
+                    delta.count++;
+                }
+            }
+        });
+        char unit = self->unit;
+        CPyObject d(PyDict_New());
+        for(size_t n = 0; n < delta.count; n++) {
+            const TrackedField &field = trackedFields[delta.field[n]];
+            long v = delta.value[n];
+            CPyObject value;
+            switch(field.kind) {
+                case TRACKED_TEMP:
+                    value = tempToPyFloat(unit, v);
+                    break;
+                case TRACKED_TEMP_DIFF:
+                    value = tempDiffToPyFloat(unit, v);
+                    break;
+                case TRACKED_LONG_TEMP_DIFF:
+                    value = longTempDiffToPyFloat(unit, v);
+                    break;
+                case TRACKED_BOOL:
+                    value = CPyObject(PyBool_FromLong(v));
+                    break;
+                default:
+                    value = CPyObject(PyLong_FromLong(v));
+                    break;
+            }
+            if(PyDict_SetItemString(d, field.name, value) < 0) {
+                throw std::exception();
+            }
+        }
+        return Py_BuildValue("(kO)", delta.version, (PyObject *)d);
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyObject *
+TempControl_getControlVariables(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    try {
+        CPyObject d(PyDict_New());
+        char unit = self->unit;
+        ControlVariables cv = withChamber(self, [](TempControlRefs &refs) {
+            return refs.controller().cv;
+        });
+        PyDict_SetItemString(d, "beerDiff", tempDiffToPyFloat(unit, cv.beerDiff));
+        PyDict_SetItemString(d, "diffIntegral", longTempDiffToPyFloat(unit, cv.diffIntegral));
+        PyDict_SetItemString(d, "beerSlope", tempDiffToPyFloat(unit, cv.beerSlope));
+        PyDict_SetItemString(d, "p", longTempDiffToPyFloat(unit, cv.p));
+        PyDict_SetItemString(d, "i", longTempDiffToPyFloat(unit, cv.i));
+        PyDict_SetItemString(d, "d", longTempDiffToPyFloat(unit, cv.d));
+        PyDict_SetItemString(d, "estimatedPeak", tempDiffToPyFloat(unit, cv.estimatedPeak));
+        PyDict_SetItemString(d, "negPeakEstimate", tempDiffToPyFloat(unit, cv.negPeakEstimate));
+        PyDict_SetItemString(d, "posPeakEstimate", tempDiffToPyFloat(unit, cv.posPeakEstimate));
+        PyDict_SetItemString(d, "negPeak", tempDiffToPyFloat(unit, cv.negPeak));
+        PyDict_SetItemString(d, "posPeak", tempDiffToPyFloat(unit, cv.posPeak));
+        return d.release();
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyObject *
+TempControl_getControlConstants(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    try {
+        char unit = self->unit;
+        unsigned long generation;
+        ControlConstants cc = withChamber(self, [&generation](TempControlRefs &refs) {
+            refs.noteChanges();
+            generation = refs.constantsGeneration;
+            return refs.controller().cc;
+        });
+        if(self->constantsCache != NULL && self->constantsCacheGeneration == generation) {
+            Py_INCREF(self->constantsCache);
+            return self->constantsCache;
+        }
+        CPyObject d(PyDict_New());
+        PyDict_SetItemString(d, "tempFormats", CPyObject(PyLong_FromLong(cc.tempFormat)));
+        PyDict_SetItemString(d, "tempSettingMin", tempToPyFloat(unit, cc.tempSettingMin));
+        PyDict_SetItemString(d, "tempSettingMax", tempToPyFloat(unit, cc.tempSettingMax));
+        PyDict_SetItemString(d, "Kp", tempDiffToPyFloat(unit, cc.Kp));
+        PyDict_SetItemString(d, "Ki", tempDiffToPyFloat(unit, cc.Ki));
+        PyDict_SetItemString(d, "Kd", tempDiffToPyFloat(unit, cc.Kd));
+        PyDict_SetItemString(d, "iMaxError", tempDiffToPyFloat(unit, cc.iMaxError));
+        PyDict_SetItemString(d, "idleRangeHigh", tempDiffToPyFloat(unit, cc.idleRangeHigh));
+        PyDict_SetItemString(d, "idleRangeLow", tempDiffToPyFloat(unit, cc.idleRangeLow));
+        PyDict_SetItemString(d, "heatingTargetUpper", tempDiffToPyFloat(unit, cc.heatingTargetUpper));
+        PyDict_SetItemString(d, "heatingTargetLower", tempDiffToPyFloat(unit, cc.heatingTargetLower));
+        PyDict_SetItemString(d, "coolingTargetUpper", tempDiffToPyFloat(unit, cc.coolingTargetUpper));
+        PyDict_SetItemString(d, "coolingTargetLower", tempDiffToPyFloat(unit, cc.coolingTargetLower));
+        PyDict_SetItemString(d, "maxHeatTimeForEstimate", CPyObject(PyLong_FromLong(cc.maxHeatTimeForEstimate)));
+        PyDict_SetItemString(d, "maxCoolTimeForEstimate", CPyObject(PyLong_FromLong(cc.maxCoolTimeForEstimate)));
+        PyDict_SetItemString(d, "fridgeFastFilter", CPyObject(PyLong_FromLong(cc.fridgeFastFilter)));
+        PyDict_SetItemString(d, "fridgeSlowFilter", CPyObject(PyLong_FromLong(cc.fridgeSlowFilter)));
+        PyDict_SetItemString(d, "fridgeSlopeFilter", CPyObject(PyLong_FromLong(cc.fridgeSlopeFilter)));
+        PyDict_SetItemString(d, "beerFastFilter", CPyObject(PyLong_FromLong(cc.beerFastFilter)));
+        PyDict_SetItemString(d, "beerSlowFilter", CPyObject(PyLong_FromLong(cc.beerSlowFilter)));
+        PyDict_SetItemString(d, "beerSlopeFilter", CPyObject(PyLong_FromLong(cc.beerSlopeFilter)));
+        PyDict_SetItemString(d, "lightAsHeater", CPyObject(PyLong_FromLong(cc.lightAsHeater)));
+        PyDict_SetItemString(d, "rotaryHalfSteps", CPyObject(PyLong_FromLong(cc.rotaryHalfSteps)));
+        PyDict_SetItemString(d, "pidMax", tempDiffToPyFloat(unit, cc.pidMax));
+        return cacheMapping(&self->constantsCache, &self->constantsCacheGeneration, d, generation);
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   Replaces the beer/fridge sensors and heater/cooler with
+   a simulated chamber, see simulator.h.  Temperatures are
+   in the unit of this object.
+
+   python: setSimulator(beerTemp=, fridgeTemp=, roomTemp=, beerMass=,
+                        fridgeCapacity=, heaterPower=, coolerPower=,
+                        beerTransfer=, roomTransfer=)
+   */
+static PyObject *
+TempControl_setSimulator(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
+    try {
+        char unit = self->unit;
+        PlantParams params;
+        params.beerTemp = internalToUnit(unit, params.beerTemp);
+        params.fridgeTemp = internalToUnit(unit, params.fridgeTemp);
+        params.roomTemp = internalToUnit(unit, params.roomTemp);
+        static const char *kwlist[] = {"beerTemp", "fridgeTemp", "roomTemp", "beerMass",
+            "fridgeCapacity", "heaterPower", "coolerPower", "beerTransfer", "roomTransfer", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|$ddddddddd", (char **) kwlist,
+                    &params.beerTemp, &params.fridgeTemp, &params.roomTemp, &params.beerMass,
+                    &params.fridgeCapacity, &params.heaterPower, &params.coolerPower,
+                    &params.beerTransfer, &params.roomTransfer)) {
+            return NULL;
+        }
+        params.beerTemp = unitToInternal(unit, params.beerTemp);
+        params.fridgeTemp = unitToInternal(unit, params.fridgeTemp);
+        params.roomTemp = unitToInternal(unit, params.roomTemp);
+
+        auto simulator = std::make_unique<Simulator>(params);
+        auto basicBeerSensor = std::make_unique<SimTempSensor>(&simulator->beerTemp);
+        auto beerSensor = std::make_unique<TempSensor>(TEMP_SENSOR_TYPE_BEER, basicBeerSensor.get());
+        auto basicFridgeSensor = std::make_unique<SimTempSensor>(&simulator->fridgeTemp);
+        auto fridgeSensor = std::make_unique<TempSensor>(TEMP_SENSOR_TYPE_FRIDGE, basicFridgeSensor.get());
+        beerSensor->init();
+        fridgeSensor->init();
+
+        std::unique_ptr<BasicTempSensor> oldBasicBeerSensor(std::move(basicBeerSensor));
+        std::unique_ptr<TempSensor> oldBeerSensor(std::move(beerSensor));
+        std::unique_ptr<BasicTempSensor> oldBasicFridgeSensor(std::move(basicFridgeSensor));
+        std::unique_ptr<TempSensor> oldFridgeSensor(std::move(fridgeSensor));
+        std::unique_ptr<Actuator> oldHeater(std::make_unique<SimActuator>(&simulator->heating));
+        std::unique_ptr<Actuator> oldCooler(std::make_unique<SimActuator>(&simulator->cooling));
+        // the replaced python sensors and switches are freed
+        // when these go out of scope, with the GIL held
+        withChamber(self, [&](TempControlRefs &refs) {
+            TempControl &tc = refs.controller();
+            std::swap(refs.basicBeerSensor, oldBasicBeerSensor);
+            std::swap(refs.beerSensor, oldBeerSensor);
+            std::swap(refs.basicFridgeSensor, oldBasicFridgeSensor);
+            std::swap(refs.fridgeSensor, oldFridgeSensor);
+            std::swap(refs.heater, oldHeater);
+            std::swap(refs.cooler, oldCooler);
+            std::swap(refs.simulator, simulator);
+            tc.beerSensor = refs.beerSensor.get();
+            tc.fridgeSensor = refs.fridgeSensor.get();
+            tc.heater = refs.heater.get();
+            tc.cooler = refs.cooler.get();
+        });
+
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   Runs the simulated chamber for duration seconds with a
+   control tick every dt seconds, returning every record'th
+   tick as (time, beerTemp, fridgeTemp, state, heating, cooling)
+
+   python: simulate(duration, dt=1.0, record=1)
+   */
+static PyObject *
+TempControl_simulate(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
+    try {
+        double duration;
+        double dt = 1.0;
+        unsigned long record = 1;
+        static const char *kwlist[] = {"duration", "dt", "record", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "d|dk", (char **) kwlist, &duration, &dt, &record)) {
+            return NULL;
+        }
+        if(dt <= 0) {
+            PyErr_SetString(PyExc_RuntimeError, "dt must be positive");
+            return NULL;
+        }
+
+        std::vector<SimSample> trajectory;
+        if(record != 0) {
+            trajectory.reserve((unsigned long)(duration / dt) / record + 1);
+        }
+        bool simulated = withChamber(self, [&](TempControlRefs &refs) {
+            if(!refs.simulator) {
+                return false;
+            }
+            refs.simulator->run([&refs]() { return refs.tick(); }, duration, dt, record, trajectory);
+            return true;
+        });
+        if(!simulated) {
+            PyErr_SetString(PyExc_RuntimeError, "no simulator set");
+            return NULL;
+        }
+
+        char unit = self->unit;
+        CPyObject l(PyList_New(trajectory.size()));
+        for(size_t n = 0; n < trajectory.size(); n++) {
+            const SimSample &s = trajectory[n];
+            PyObject *item = Py_BuildValue("(dddiOO)", s.time,
+                    internalToUnit(unit, s.beerTemp), internalToUnit(unit, s.fridgeTemp), s.state,
+                    s.heating ? Py_True : Py_False, s.cooling ? Py_True : Py_False);
+            if(item == NULL) {
+                return NULL;
+            }
+            PyList_SET_ITEM((PyObject *) l, n, item);
+        }
+        return l.release();
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   StateView is a live, read only view over cs, cv and cc of
+   a TempControl object.  The first attribute read copies every
+   field under a single lock of the chamber, later reads convert
+   from that copy to the unit of the owner for as long as the
+   chamber was not locked again (by a tick, a setter, ...), so a
+   batch of reads between ticks costs one lock.  A poller can keep
+   one view around and read only what it needs.
+
+   python: v = tempControl.getStateView()
+           v.beerSetting, v.beerDiff, v.Kp, v.state, ...
+   */
+enum StateFieldKind {
+    STATE_FIELD_TEMP,
+    STATE_FIELD_TEMP_DIFF,
+    // the long_temperature fields of cv
+    STATE_FIELD_LONG_TEMP_DIFF,
+    STATE_FIELD_INT
+};
+
+struct StateField {
+    const char *name;
+    // 's', 'v' or 'c' for cs, cv and cc, 0 for derived fields
+    char group;
+    long (*read)(TempControl &tc);
+    void (*write)(TempControl &tc, long v);
+    StateFieldKind kind;
+};
+
+#define STATE_FIELD(group, name, kind) \
+    {#name, #group[1], \
+        [](TempControl &tc) -> long { return tc.group.name; }, \
+        [](TempControl &tc, long v) { tc.group.name = v; }, \
+        kind}
+
+static StateField stateFields[] = {
+    STATE_FIELD(cs, mode, STATE_FIELD_INT),
+    STATE_FIELD(cs, beerSetting, STATE_FIELD_TEMP),
+    STATE_FIELD(cs, fridgeSetting, STATE_FIELD_TEMP),
+    STATE_FIELD(cs, heatEstimator, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cs, coolEstimator, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cv, beerDiff, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cv, diffIntegral, STATE_FIELD_LONG_TEMP_DIFF),
+    STATE_FIELD(cv, beerSlope, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cv, p, STATE_FIELD_LONG_TEMP_DIFF),
+    STATE_FIELD(cv, i, STATE_FIELD_LONG_TEMP_DIFF),
+    STATE_FIELD(cv, d, STATE_FIELD_LONG_TEMP_DIFF),
+    STATE_FIELD(cv, estimatedPeak, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cv, negPeakEstimate, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cv, posPeakEstimate, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cv, negPeak, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cv, posPeak, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cc, tempFormat, STATE_FIELD_INT),
+    STATE_FIELD(cc, tempSettingMin, STATE_FIELD_TEMP),
+    STATE_FIELD(cc, tempSettingMax, STATE_FIELD_TEMP),
+    STATE_FIELD(cc, Kp, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cc, Ki, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cc, Kd, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cc, iMaxError, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cc, idleRangeHigh, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cc, idleRangeLow, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cc, heatingTargetUpper, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cc, heatingTargetLower, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cc, coolingTargetUpper, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cc, coolingTargetLower, STATE_FIELD_TEMP_DIFF),
+    STATE_FIELD(cc, maxHeatTimeForEstimate, STATE_FIELD_INT),
+    STATE_FIELD(cc, maxCoolTimeForEstimate, STATE_FIELD_INT),
+    STATE_FIELD(cc, fridgeFastFilter, STATE_FIELD_INT),
+    STATE_FIELD(cc, fridgeSlowFilter, STATE_FIELD_INT),
+    STATE_FIELD(cc, fridgeSlopeFilter, STATE_FIELD_INT),
+    STATE_FIELD(cc, beerFastFilter, STATE_FIELD_INT),
+    STATE_FIELD(cc, beerSlowFilter, STATE_FIELD_INT),
+    STATE_FIELD(cc, beerSlopeFilter, STATE_FIELD_INT),
+    STATE_FIELD(cc, lightAsHeater, STATE_FIELD_INT),
+    STATE_FIELD(cc, rotaryHalfSteps, STATE_FIELD_INT),
+    STATE_FIELD(cc, pidMax, STATE_FIELD_TEMP_DIFF),
+    {"state", 0, [](TempControl &tc) -> long { return tc.getState(); }, NULL, STATE_FIELD_INT},
+};
+
+#define STATE_FIELD_COUNT (sizeof(stateFields) / sizeof(stateFields[0]))
+
+static const StateField *
+findStateField(const char *name) {
+    for(size_t n = 0; n < STATE_FIELD_COUNT; n++) {
+        if(strcmp(stateFields[n].name, name) == 0) {
+            return &stateFields[n];
+        }
+    }
+    return nullptr;
+}
+
+// raw field value to a python number in unit
+static CPyObject
+stateFieldToPy(const StateField *field, char unit, long v) {
+    switch(field->kind) {
+        case STATE_FIELD_TEMP:
+            return tempToPyFloat(unit, v);
+        case STATE_FIELD_TEMP_DIFF:
+            return tempDiffToPyFloat(unit, v);
+        case STATE_FIELD_LONG_TEMP_DIFF:
+            return longTempDiffToPyFloat(unit, v);
+        default:
+            return CPyObject(PyLong_FromLong(v));
+    }
+}
+
+// python number in unit to a raw field value
+static long
+stateFieldFromPy(const StateField *field, char unit, PyObject *n) {
+    switch(field->kind) {
+        case STATE_FIELD_TEMP:
+            return pyNumToTemp(unit, n);
+        case STATE_FIELD_TEMP_DIFF:
+            return pyNumToTempDiff(unit, n);
+        case STATE_FIELD_LONG_TEMP_DIFF:
+            return pyNumToLongTempDiff(unit, n);
+        default:
+            return pyNumToLong(n);
+    }
+}
+
+typedef struct {
+    PyObject_HEAD
+    TempControl_Object *owner;
+    // the fields as of epoch of the owner, if valid
+    bool valid;
+    unsigned long epoch;
+    long values[STATE_FIELD_COUNT];
+} StateView_Object;
+
+static void
+StateView_dealloc__(StateView_Object *self) {
+    Py_XDECREF(self->owner);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *
+StateView_get(StateView_Object *self, void *closure) {
+    try {
+        const StateField *field = (const StateField *) closure;
+        TempControlRefs *refs = self->owner->refs;
+        if(!self->valid || refs->epoch.load(std::memory_order_acquire) != self->epoch) {
+            // filled without the GIL, so into a copy another thread can't see
+            long values[STATE_FIELD_COUNT];
+            unsigned long epoch = withChamber(self->owner, [&values](TempControlRefs &refs) {
+                for(size_t n = 0; n < STATE_FIELD_COUNT; n++) {
+                    values[n] = stateFields[n].read(refs.controller());
+                }
+                return refs.epoch.load(std::memory_order_relaxed);
+            });
+            memcpy(self->values, values, sizeof(values));
+            self->epoch = epoch;
+            self->valid = true;
+        }
+        return stateFieldToPy(field, self->owner->unit, self->values[field - stateFields]).release();
+    } catch(...) {
+        return NULL;
+    }
+}
+
+// filled from stateFields at module init
+static PyGetSetDef StateView_getset[STATE_FIELD_COUNT + 1];
+
+static PyTypeObject StateView_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "TempControl.StateView",             /* tp_name */
+    sizeof(StateView_Object), /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor) StateView_dealloc__,     /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,        /* tp_flags */
+    "live view of TempControl cs, cv and cc",           /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    0,             /* tp_methods */
+    0,             /* tp_members */
+    StateView_getset,                         /* tp_getset */
+};
+
+static int
+StateView_ready() {
+    for(size_t n = 0; n < STATE_FIELD_COUNT; n++) {
+        StateView_getset[n].name = stateFields[n].name;
+        StateView_getset[n].get = (getter) StateView_get;
+        StateView_getset[n].closure = &stateFields[n];
+    }
+    return PyType_Ready(&StateView_Type);
+}
+
+static PyObject *
+TempControl_getStateView(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    StateView_Object *view = PyObject_New(StateView_Object, &StateView_Type);
+    if(view == NULL) {
+        return NULL;
+    }
+    Py_INCREF(self);
+    view->owner = self;
+    view->valid = false;
+    return (PyObject *) view;
+}
+
+/*
+   Recorder is the python side of a chamber's Recorder, see
+   recorder.h.  It exports the ring through the buffer protocol
+   as a 1-d array of records, so
+
+       a = numpy.asarray(recorder)
+       history = numpy.roll(a[:recorder.count], -recorder.start)
+
+   gives the history oldest first without copying the ring.  A
+   request without a shape (PyBUF_SIMPLE) gets the ring as bytes.
+   */
+typedef struct {
+    PyObject_HEAD
+    // the chamber that records into it, whose lock guards the ring
+    TempControl_Object *owner;
+    std::shared_ptr<Recorder> *recorder;
+    Py_ssize_t shape;
+    Py_ssize_t stride;
+} Recorder_Object;
+
+static void
+Recorder_dealloc__(Recorder_Object *self) {
+    delete(self->recorder);
+    Py_XDECREF(self->owner);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static int
+Recorder_getbuffer(Recorder_Object *self, Py_buffer *view, int flags) {
+    if(flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "recorder is read only");
+        return -1;
+    }
+    Recorder &recorder = **self->recorder;
+    view->obj = (PyObject *) self;
+    Py_INCREF(self);
+    view->buf = recorder.records.data();
+    view->len = recorder.capacity() * sizeof(Record);
+    view->readonly = 1;
+    view->ndim = 1;
+    if(flags & PyBUF_ND) {
+        view->itemsize = sizeof(Record);
+        view->format = (flags & PyBUF_FORMAT) ? (char *) RECORD_FORMAT : NULL;
+        view->shape = &self->shape;
+    } else {
+        // unshaped, the consumer sees len unsigned bytes, as PyBuffer_FillInfo exports them
+        view->itemsize = 1;
+        view->format = (flags & PyBUF_FORMAT) ? (char *) "B" : NULL;
+        view->shape = NULL;
+    }
+    view->strides = (flags & PyBUF_STRIDES) ? &self->stride : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static PyBufferProcs Recorder_BufferProcs = {
+    (getbufferproc) Recorder_getbuffer,
+    NULL,
+};
+
+static PyObject *
+Recorder_getCapacity(Recorder_Object *self, void *closure) {
+    return PyLong_FromSize_t((*self->recorder)->capacity());
+}
+
+// start and count move with every tick, they are read under the chamber lock
+static PyObject *
+Recorder_getStart(Recorder_Object *self, void *closure) {
+    try {
+        Recorder *recorder = self->recorder->get();
+        size_t start = withChamber(self->owner, [recorder](TempControlRefs &refs) {
+            return recorder->start;
+        });
+        return PyLong_FromSize_t(start);
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyObject *
+Recorder_getCount(Recorder_Object *self, void *closure) {
+    try {
+        Recorder *recorder = self->recorder->get();
+        size_t count = withChamber(self->owner, [recorder](TempControlRefs &refs) {
+            return recorder->count;
+        });
+        return PyLong_FromSize_t(count);
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyGetSetDef Recorder_getset[] = {
+    {"capacity", (getter) Recorder_getCapacity, NULL, NULL, NULL},
+    {"start", (getter) Recorder_getStart, NULL, NULL, NULL},
+    {"count", (getter) Recorder_getCount, NULL, NULL, NULL},
+    {NULL}        /* Sentinel */
+};
+
+static PyObject *
+Recorder_clear(Recorder_Object *self, PyObject *args) {
+    try {
+        Recorder *recorder = self->recorder->get();
+        withChamber(self->owner, [recorder](TempControlRefs &refs) {
+            recorder->clear();
+        });
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyMethodDef Recorder_Methods[] = {
+    {"clear", (PyCFunction) Recorder_clear, METH_NOARGS, NULL},
+    {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+
+static PyTypeObject Recorder_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "TempControl.Recorder",             /* tp_name */
+    sizeof(Recorder_Object), /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor) Recorder_dealloc__,     /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    &Recorder_BufferProcs,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,        /* tp_flags */
+    "per tick history of a TempControl",           /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    Recorder_Methods,             /* tp_methods */
+    0,             /* tp_members */
+    Recorder_getset,                         /* tp_getset */
+};
+
+/*
+   Starts recording the last capacity ticks, replacing any
+   previous recorder.  A capacity of 0 stops recording.
+
+   python: setRecorder(capacity) -> Recorder or None
+   */
+static PyObject *
+TempControl_setRecorder(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    try {
+        Py_ssize_t capacity;
+        if(!PyArg_ParseTuple(args, "n", &capacity)) {
+            return NULL;
+        }
+        if(capacity < 0) {
+            PyErr_SetString(PyExc_RuntimeError, "capacity must not be negative");
+            return NULL;
+        }
+        if(capacity == 0) {
+            withChamber(self, [](TempControlRefs &refs) {
+                refs.recorder.reset();
+            });
+            Py_RETURN_NONE;
+        }
+
+        Recorder_Object *r = PyObject_New(Recorder_Object, &Recorder_Type);
+        if(r == NULL) {
+            return NULL;
+        }
+        CPyObject py_recorder((PyObject *) r);
+        r->recorder = nullptr;
+        Py_INCREF(self);
+        r->owner = self;
+        r->shape = capacity;
+        r->stride = sizeof(Record);
+        r->recorder = new std::shared_ptr<Recorder>(std::make_shared<Recorder>(capacity));
+        std::shared_ptr<Recorder> recorder = *r->recorder;
+        withChamber(self, [&recorder](TempControlRefs &refs) {
+            refs.recorder = recorder;
+        });
+        return py_recorder.release();
+    } catch(std::bad_alloc &) {
+        PyErr_NoMemory();
+        return NULL;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   Replays a trace file through a copy of this chamber, see
+   replay.h.  The replay starts from the chamber's state, the
+   chamber itself is left as it was.  Returns three bytes per
+   sample: state, heater, cooler.
+
+   python: replay(path) -> bytes
+   */
+static PyObject *
+TempControl_replay(TempControl_Object *self, PyObject *args) {
+    TIME_METHOD();
+    try {
+        const char *path;
+        if(!PyArg_ParseTuple(args, "s", &path)) {
+            return NULL;
+        }
+        TraceFile trace(path);
+        std::vector<ReplayDecision> decisions;
+        withChamber(self, [&](TempControlRefs &refs) {
+            // the chamber itself keeps its state, recorder and profile
+            ScratchControl scratch(refs);
+            replayTrace(scratch.refs(), trace, decisions);
+        });
+        static_assert(sizeof(ReplayDecision) == 3, "ReplayDecision must be packed");
+        return PyBytes_FromStringAndSize((const char *) decisions.data(),
+                decisions.size() * sizeof(ReplayDecision));
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   Looks up a control constant for sweep, only cc fields
+   may be varied
+   */
+static const StateField *
+sweepField(PyObject *key) {
+    const char *name = PyUnicode_AsUTF8(key);
+    if(name == NULL) {
+        throw std::exception();
+    }
+    const StateField *field = findStateField(name);
+    if(field == nullptr || field->group != 'c') {
+        pyerr_printf("not a control constant: %s", name);
+        throw std::exception();
+    }
+    return field;
+}
+
+/*
+   Scores candidate control constants against this object's plant,
+   the simulator or, with trace, a recorded trace file, see
+   sweep.h.  Every candidate starts from this controller's current
+   cs and cc, and either
+
+     candidates  is a list of dicts of cc fields to override, or
+     ranges      is a dict of cc field -> (low, high), from which
+                 samples candidates are drawn uniformly
+
+   Values are in the unit of this object.  Returns one dict per
+   candidate with the constants that were varied and its scores.
+   duration is required for the simulator, a trace runs to its end
+   unless duration is given.
+
+   python: sweep(duration=0, candidates=None, ranges=None, samples=0,
+                 seed=0, dt=1.0, band=0.5, threads=0, trace=None)
+   */
+static PyObject *
+TempControl_sweep(TempControl_Object *self, PyObject *args, PyObject *kwds) {
+    TIME_METHOD();
+    try {
+        SweepSetup setup;
+        PyObject *candidates = NULL;
+        PyObject *ranges = NULL;
+        Py_ssize_t samples = 0;
+        unsigned long seed = 0;
+        unsigned threads = 0;
+        const char *tracePath = NULL;
+        setup.duration = 0;
+        setup.dt = 1.0;
+        double band = 0.5;
+        static const char *kwlist[] = {"duration", "candidates", "ranges", "samples",
+            "seed", "dt", "band", "threads", "trace", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|d$OOnkddIz", (char **) kwlist,
+                    &setup.duration, &candidates, &ranges, &samples, &seed,
+                    &setup.dt, &band, &threads, &tracePath)) {
+            return NULL;
+        }
+        if((candidates == NULL) == (ranges == NULL)) {
+            PyErr_SetString(PyExc_RuntimeError, "must specify only candidates or only ranges");
+            return NULL;
+        }
+        if(setup.dt <= 0) {
+            PyErr_SetString(PyExc_RuntimeError, "dt must be positive");
+            return NULL;
+        }
+        if(tracePath == NULL ? !(setup.duration > 0) : !(setup.duration >= 0)) {
+            PyErr_SetString(PyExc_RuntimeError, "duration must be positive");
+            return NULL;
+        }
+        std::unique_ptr<TraceFile> trace;
+        if(tracePath != NULL) {
+            trace.reset(new TraceFile(tracePath));
+            if(trace->count() == 0) {
+                PyErr_SetString(PyExc_RuntimeError, "trace has no samples");
+                return NULL;
+            }
+            setup.trace = trace.get();
+        }
+        char unit = self->unit;
+        setup.band = unitToInternalDiff(unit, band);
+
+        // the fields each candidate overrides, in internal format
+        typedef std::vector<std::pair<const StateField *, long>> Overrides;
+        std::vector<Overrides> overrides;
+        if(candidates != NULL) {
+            CPyObject seq(PySequence_Fast(candidates, "candidates must be a sequence"));
+            Py_ssize_t count = PySequence_Fast_GET_SIZE((PyObject *) seq);
+            for(Py_ssize_t n = 0; n < count; n++) {
+                PyObject *d = PySequence_Fast_GET_ITEM((PyObject *) seq, n);
+                if(!PyDict_Check(d)) {
+                    PyErr_SetString(PyExc_RuntimeError, "dictionary expected");
+                    return NULL;
+                }
+                overrides.emplace_back();
+                PyObject *key, *value;
+                Py_ssize_t pos = 0;
+                while(PyDict_Next(d, &pos, &key, &value)) {
+                    const StateField *field = sweepField(key);
+                    overrides.back().emplace_back(field, stateFieldFromPy(field, unit, value));
+                }
+            }
+        } else {
+            if(!PyDict_Check(ranges)) {
+                PyErr_SetString(PyExc_RuntimeError, "dictionary expected");
+                return NULL;
+            }
+            std::vector<const StateField *> fields;
+            std::vector<std::uniform_real_distribution<double>> dists;
+            PyObject *key, *value;
+            Py_ssize_t pos = 0;
+            while(PyDict_Next(ranges, &pos, &key, &value)) {
+                double low, high;
+                if(!PyArg_ParseTuple(value, "dd", &low, &high)) {
+                    return NULL;
+                }
+                fields.push_back(sweepField(key));
+                dists.emplace_back(low, high);
+            }
+            std::mt19937 random(seed);
+            for(Py_ssize_t n = 0; n < samples; n++) {
+                overrides.emplace_back();
+                for(size_t f = 0; f < fields.size(); f++) {
+                    CPyObject v(PyFloat_FromDouble(dists[f](random)));
+                    overrides.back().emplace_back(fields[f], stateFieldFromPy(fields[f], unit, v));
+                }
+            }
+        }
+
+        if(threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        // candidate constants, and the overrides as the fields took them
+        std::vector<ControlConstants> cc;
+        std::vector<SweepScore> scores;
+        bool plant = withChamber(self, [&](TempControlRefs &refs) {
+            if(!refs.simulator && setup.trace == nullptr) {
+                return false;
+            }
+            if(refs.simulator) {
+                setup.plant = refs.simulator->params;
+            }
+            setup.cs = refs.controller().cs;
+            if(refs.profile) {
+                setup.profile = refs.profile->resumed();
+            }
+            {
+                // the static build only has the chamber's controller to write fields into
+                ScratchControl scratch(refs);
+                TempControl &tc = scratch.refs().controller();
+                ControlConstants base = tc.cc;
+                for(Overrides &o : overrides) {
+                    tc.cc = base;
+                    for(auto &field : o) {
+                        field.first->write(tc, field.second);
+                    }
+                    for(auto &field : o) {
+                        field.second = field.first->read(tc);
+                    }
+                    cc.push_back(tc.cc);
+                }
+            }
+#if TEMP_CONTROL_STATIC
+            runSweep(refs, setup, cc, threads, scores);
+#endif
+            return true;
+        });
+        if(!plant) {
+            PyErr_SetString(PyExc_RuntimeError, "no simulator set");
+            return NULL;
+        }
+#if !TEMP_CONTROL_STATIC
+        {
+            // the candidates have controllers of their own, the chamber stays unlocked
+            GILRelease nogil;
+            runSweep(*self->refs, setup, cc, threads, scores);
+        }
+#endif
+
+        CPyObject l(PyList_New(scores.size()));
+        for(size_t n = 0; n < scores.size(); n++) {
+            CPyObject constants(PyDict_New());
+            for(auto &field : overrides[n]) {
+                PyDict_SetItemString(constants, field.first->name,
+                        stateFieldToPy(field.first, unit, field.second));
+            }
+            const SweepScore &score = scores[n];
+            PyObject *item = Py_BuildValue("{s:O,s:d,s:d,s:d,s:k,s:k}",
+                    "constants", (PyObject *) constants,
+                    "overshoot", internalDiffToUnit(unit, score.overshoot),
+                    "settlingTime", score.settlingTime,
+                    "rmsError", internalDiffToUnit(unit, score.rmsError),
+                    "coolerCycles", score.coolerCycles,
+                    "heaterCycles", score.heaterCycles);
+            if(item == NULL) {
+                return NULL;
+            }
+            PyList_SET_ITEM((PyObject *) l, n, item);
+        }
+        return l.release();
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyMethodDef TempControl_Methods[] = {
+    {"init", (PyCFunction) TempControl_init, METH_NOARGS, NULL},
+    {"reset", (PyCFunction) TempControl_reset, METH_NOARGS, NULL},
+    {"updateTemperatures", (PyCFunction) TempControl_updateTemperatures, METH_NOARGS, NULL},
+    {"updatePID", (PyCFunction) TempControl_updatePID, METH_NOARGS, NULL},
+    {"getState", (PyCFunction) TempControl_getState, METH_NOARGS, NULL},
+    {"updateState", (PyCFunction) TempControl_updateState, METH_NOARGS, NULL},
+    {"updateOutputs", (PyCFunction) TempControl_updateOutputs, METH_NOARGS, NULL},
+    {"detectPeaks", (PyCFunction) TempControl_detectPeaks, METH_NOARGS, NULL},
+    {"loadDefaultSettings", (PyCFunction) TempControl_loadDefaultSettings, METH_NOARGS, NULL},
+    {"loadDefaultConstants", (PyCFunction) TempControl_loadDefaultConstants, METH_NOARGS, NULL},
+    {"setEeprom", (PyCFunction) TempControl_setEeprom, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"save", (PyCFunction) TempControl_save, METH_NOARGS, NULL},
+    {"load", (PyCFunction) TempControl_load, METH_NOARGS, NULL},
+    {"snapshot", (PyCFunction) TempControl_snapshot, METH_NOARGS, NULL},
+    {"restore", (PyCFunction) TempControl_restore, METH_VARARGS, NULL},
+    {"setBeerTemp", (PyCFunction) TempControl_setBeerTemp, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"setFridgeTemp", (PyCFunction) TempControl_setFridgeTemp, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"setMode", (PyCFunction) TempControl_setMode, METH_VARARGS, NULL},
+    {"setProfile", (PyCFunction) TempControl_setProfile, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"getProfile", (PyCFunction) TempControl_getProfile, METH_NOARGS, NULL},
+    {"setBeerSensor", (PyCFunction) TempControl_setBeerSensor, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"setFridgeSensor", (PyCFunction) TempControl_setFridgeSensor, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"setHeater", (PyCFunction) TempControl_setHeater, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"setCooler", (PyCFunction) TempControl_setCooler, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"initFilters", (PyCFunction) TempControl_initFilters, METH_NOARGS, NULL},
+    {"tick", (PyCFunction) TempControl_tick, METH_NOARGS, NULL},
+    {"tickAsync", (PyCFunction) TempControl_tickAsync, METH_NOARGS, NULL},
+    {"startScheduler", (PyCFunction) TempControl_startScheduler, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"stopScheduler", (PyCFunction) TempControl_stopScheduler, METH_NOARGS, NULL},
+    {"schedulerStats", (PyCFunction) TempControl_schedulerStats, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"setSimulator", (PyCFunction) TempControl_setSimulator, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"simulate", (PyCFunction) TempControl_simulate, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"getControlSettings", (PyCFunction) TempControl_getControlSettings, METH_NOARGS, NULL},
+    {"generation", (PyCFunction) TempControl_generation, METH_NOARGS, NULL},
+    {"chamberId", (PyCFunction) TempControl_chamberId, METH_NOARGS, NULL},
+    {"setControlSettings", (PyCFunction) TempControl_setControlSettings, METH_VARARGS, NULL},
+    {"getControlVariables", (PyCFunction) TempControl_getControlVariables, METH_NOARGS, NULL},
+    {"changesSince", (PyCFunction) TempControl_changesSince, METH_VARARGS, NULL},
+    {"setControlVariables", (PyCFunction) TempControl_setControlVariables, METH_VARARGS, NULL},
+    {"getControlConstants", (PyCFunction) TempControl_getControlConstants, METH_NOARGS, NULL},
+    {"getStateView", (PyCFunction) TempControl_getStateView, METH_NOARGS, NULL},
+    {"setRecorder", (PyCFunction) TempControl_setRecorder, METH_VARARGS, NULL},
+    {"replay", (PyCFunction) TempControl_replay, METH_VARARGS, NULL},
+    {"sweep", (PyCFunction) TempControl_sweep, METH_VARARGS | METH_KEYWORDS, NULL},
+    {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+
+static PyTypeObject TempControl_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "TempControl.TempControl",             /* tp_name */
+    sizeof(TempControl_Object), /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor) TempControl_dealloc__,     /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,        /* tp_flags */
+    "TempControl",           /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    TempControl_Methods,             /* tp_methods */
+    0,             /* tp_members */
+    0,                         /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc) TempControl_init__,      /* tp_init */
+    0,                         /* tp_alloc */
+    TempControl_new__,                 /* tp_new */
+};
+
+/*
+   Scheduler runs many TempControl objects from one native thread,
+   spread evenly over the period, see TimerWheel.
+
+   python: Scheduler(period=1.0, slots=20)
+           add(tempControl), remove(tempControl)
+           start(), stop()
+           stats(reset=False) -> as TempControl.schedulerStats, plus
+                                 slots and chambers
+
+   In stats ticks, misses and latency are per slot, duration is
+   how long the chambers of a slot took together, errors counts
+   chamber cycles.
+
+   With more chambers than slots, chambers share slots.  A chamber
+   can be on one Scheduler at a time, and not at the same time
+   as its own startScheduler.
+   */
+typedef struct {
+    PyObject_HEAD
+    TimerWheel *wheel;
+    // the TempControl objects added
+    PyObject *chambers;
+} Scheduler_Object;
+
+// Schedulers started, stopped at exit
+static std::vector<Scheduler_Object *> runningWheels;
+
+static void
+Scheduler_stopWheel(Scheduler_Object *self) {
+    if(!self->wheel->thread) {
+        return;
+    }
+    runningWheels.erase(std::find(runningWheels.begin(), runningWheels.end(), self));
+    GILRelease nogil;
+    self->wheel->stop();
+}
+
+static void
+Scheduler_dealloc__(Scheduler_Object *self) {
+    if(self->wheel != NULL) {
+        Scheduler_stopWheel(self);
+        delete(self->wheel);
+    }
+    if(self->chambers != NULL) {
+        for(Py_ssize_t n = 0; n < PyList_GET_SIZE(self->chambers); n++) {
+            ((TempControl_Object *) PyList_GET_ITEM(self->chambers, n))->wheel = NULL;
+        }
+        Py_DECREF(self->chambers);
+    }
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static int
+Scheduler_init__(Scheduler_Object *self, PyObject *args, PyObject *kwds) {
+    try {
+        double period = 1.0;
+        Py_ssize_t slots = 20;
+        static const char *kwlist[] = {"period", "slots", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|dn", (char **) kwlist, &period, &slots)) {
+            return -1;
+        }
+        uint64_t ns;
+        if(!parsePeriod(period, &ns)) {
+            return -1;
+        }
+        if(slots < 1 || ns / slots < 1000000) {
+            PyErr_SetString(PyExc_ValueError, "slots must be at least 1 and at least 1ms apart");
+            return -1;
+        }
+        if(self->wheel != NULL) {
+            PyErr_SetString(PyExc_RuntimeError, "Scheduler already initialized");
+            return -1;
+        }
+        // left from an __init__ that failed after it
+        if(self->chambers == NULL) {
+            self->chambers = PyList_New(0);
+            if(self->chambers == NULL) {
+                return -1;
+            }
+        }
+        self->wheel = new TimerWheel(ns, slots);
+        return 0;
+    } catch(...) {
+        return -1;
+    }
+}
+
+// the wheel, raises if __init__ did not run or failed
+static TimerWheel *
+Scheduler_wheel(Scheduler_Object *self) {
+    if(self->wheel == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "Scheduler not initialized");
+        throw std::exception();
+    }
+    return self->wheel;
+}
+
+static TempControl_Object *
+Scheduler_chamberArg(PyObject *args) {
+    PyObject *o;
+    if(!PyArg_ParseTuple(args, "O!", &TempControl_Type, &o)) {
+        throw std::exception();
+    }
+    return (TempControl_Object *) o;
+}
+
+static PyObject *
+Scheduler_add(Scheduler_Object *self, PyObject *args) {
+    try {
+        TimerWheel *wheel = Scheduler_wheel(self);
+        TempControl_Object *chamber = Scheduler_chamberArg(args);
+        if(chamber->wheel == (PyObject *) self) {
+            Py_RETURN_NONE;
+        }
+        if(chamber->wheel != NULL || chamber->scheduler != NULL) {
+            PyErr_SetString(PyExc_RuntimeError, "scheduler already running");
+            return NULL;
+        }
+        checkSyncIO(chamber);
+        if(PyList_Append(self->chambers, (PyObject *) chamber) < 0) {
+            return NULL;
+        }
+        chamber->wheel = (PyObject *) self;
+        std::function<void()> cycle = chamberCycle(chamber->refs);
+        {
+            GILRelease nogil;
+            wheel->add(chamber->refs, cycle);
+        }
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+// returns once a cycle of the chamber in progress has finished
+static PyObject *
+Scheduler_remove(Scheduler_Object *self, PyObject *args) {
+    try {
+        TimerWheel *wheel = Scheduler_wheel(self);
+        TempControl_Object *chamber = Scheduler_chamberArg(args);
+        if(chamber->wheel != (PyObject *) self) {
+            PyErr_SetString(PyExc_ValueError, "not on this scheduler");
+            return NULL;
+        }
+        {
+            GILRelease nogil;
+            wheel->remove(chamber->refs);
+        }
+        chamber->wheel = NULL;
+        Py_ssize_t n = PySequence_Index(self->chambers, (PyObject *) chamber);
+        if(n < 0 || PySequence_DelItem(self->chambers, n) < 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyObject *
+Scheduler_start(Scheduler_Object *self, PyObject *args) {
+    try {
+        TimerWheel *wheel = Scheduler_wheel(self);
+        if(!wheel->thread) {
+            wheel->start();
+            runningWheels.push_back(self);
+        }
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyObject *
+Scheduler_stop(Scheduler_Object *self, PyObject *args) {
+    try {
+        Scheduler_wheel(self);
+        Scheduler_stopWheel(self);
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyObject *
+Scheduler_stats(Scheduler_Object *self, PyObject *args, PyObject *kwds) {
+    try {
+        int reset = 0;
+        static const char *kwlist[] = {"reset", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", (char **) kwlist, &reset)) {
+            return NULL;
+        }
+        TimerWheel *wheel = Scheduler_wheel(self);
+        CPyObject stats;
+        if(wheel->thread) {
+            stats.reset(tickThreadStatsToPy(wheel->thread.get(), wheel->period / 1e9, wheel->errors.load(), reset));
+            if(reset) {
+                wheel->errors.store(0);
+            }
+        } else {
+            stats.reset(Py_BuildValue("{s:O}", "running", Py_False));
+        }
+        CPyObject slots(PyLong_FromSize_t(wheel->slots));
+        CPyObject chambers(PyLong_FromSsize_t(PyList_GET_SIZE(self->chambers)));
+        if(PyDict_SetItemString(stats, "slots", slots) < 0
+                || PyDict_SetItemString(stats, "chambers", chambers) < 0) {
+            return NULL;
+        }
+        return stats.release();
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyMethodDef Scheduler_Methods[] = {
+    {"add", (PyCFunction) Scheduler_add, METH_VARARGS, NULL},
+    {"remove", (PyCFunction) Scheduler_remove, METH_VARARGS, NULL},
+    {"start", (PyCFunction) Scheduler_start, METH_NOARGS, NULL},
+    {"stop", (PyCFunction) Scheduler_stop, METH_NOARGS, NULL},
+    {"stats", (PyCFunction) Scheduler_stats, METH_VARARGS | METH_KEYWORDS, NULL},
+    {NULL}  /* Sentinel */
+};
+
+static PyTypeObject Scheduler_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "TempControl.Scheduler",             /* tp_name */
+    sizeof(Scheduler_Object), /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor) Scheduler_dealloc__,     /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,        /* tp_flags */
+    "runs many TempControl objects from one timer wheel",           /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    Scheduler_Methods,             /* tp_methods */
+    0,             /* tp_members */
+    0,                         /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc) Scheduler_init__,      /* tp_init */
+    0,                         /* tp_alloc */
+    PyType_GenericNew,                 /* tp_new */
+};
+
+/*
+   registered with atexit, a scheduler thread that still calls
+   into python once the interpreter is finalizing gets killed
+   */
+static PyObject *
+stopAllSchedulers(PyObject *module, PyObject *args) {
+    while(!runningSchedulers.empty()) {
+        stopScheduler(runningSchedulers.back());
+    }
+    while(!runningWheels.empty()) {
+        Scheduler_stopWheel(runningWheels.back());
+    }
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef stopAllSchedulersDef = {"stopAllSchedulers", stopAllSchedulers, METH_NOARGS, NULL};
+
+/*
+   Module level clock control
+
+   python: setClock('real')
+           setClock('simulated', start=0)
+   */
+static PyObject *
+TempControl_setClock(PyObject *module, PyObject *args, PyObject *kwds) {
+    try {
+        char *kind;
+        unsigned long start = 0;
+        static const char *kwlist[] = {"kind", "start", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|k", (char **) kwlist, &kind, &start)) {
+            return NULL;
+        }
+        if(strcmp(kind, "real") == 0) {
+            moduleClock.setReal();
+        } else if(strcmp(kind, "simulated") == 0) {
+            moduleClock.setSimulated(start);
+        } else {
+            PyErr_SetString(PyExc_RuntimeError, "unknown clock specified");
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   python: advance(ms), only valid on the simulated clock
+   */
+static PyObject *
+TempControl_advance(PyObject *module, PyObject *args) {
+    try {
+        unsigned long ms;
+        if(!PyArg_ParseTuple(args, "k", &ms)) {
+            return NULL;
+        }
+        if(!moduleClock.isSimulated()) {
+            PyErr_SetString(PyExc_RuntimeError, "clock is not simulated");
+            return NULL;
+        }
+        moduleClock.advance(ms);
+        Py_RETURN_NONE;
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyObject *
+TempControl_millis(PyObject *module, PyObject *args) {
+    try {
+        return PyLong_FromUnsignedLong(millis());
+    } catch(...) {
+        return NULL;
+    }
+}
+
+// checks a unit parsed with the "C" format
+static char
+checkUnit(int unit) {
+    if(unit != 'c' && unit != 'f') {
+        PyErr_SetString(PyExc_RuntimeError, "unknown unit specified");
+        throw std::exception();
+    }
+    return unit;
+}
+
+/*
+   python: drainLog(max=0, unit='c') -> [(time, type, id, args, chamber), ...]
+   takes up to max (0 for all) records from the log ring, oldest
+   first.  args holds ints, temperatures as floats in unit and
+   strings, in the order they were logged.  The message text for
+   an id is in LogMessages.h.  chamber is the chamberId() of the
+   chamber that logged, 0 if none did.
+   */
+static PyObject *
+TempControl_drainLog(PyObject *module, PyObject *args, PyObject *kwds) {
+    try {
+        Py_ssize_t max = 0;
+        int unit = 'c';
+        static const char *kwlist[] = {"max", "unit", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|nC", (char **) kwlist, &max, &unit)) {
+            return NULL;
+        }
+        checkUnit(unit);
+        CPyObject records(PyList_New(0));
+        LogRecord r;
+        while((max == 0 || PyList_GET_SIZE((PyObject *) records) < max) && logRing.pop(r)) {
+            CPyObject values(PyTuple_New(r.argc));
+            for(int n = 0; n < r.argc; n++) {
+                CPyObject value;
+                if(r.varTypes[n] == 't') {
+                    value = tempToPyFloat(unit, r.args[n]);
+                } else if(r.varTypes[n] == 's') {
+                    value.reset(PyUnicode_DecodeLatin1(r.text + r.args[n], strlen(r.text + r.args[n]), NULL));
+                } else {
+                    value.reset(PyLong_FromLong(r.args[n]));
+                }
+                PyTuple_SET_ITEM((PyObject *) values, n, value.release());
+            }
+            CPyObject record(Py_BuildValue("(kCiOI)", r.time, r.type, r.id, (PyObject *) values, r.chamber));
+            if(PyList_Append(records, record) < 0) {
+                return NULL;
+            }
+        }
+        return records.release();
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   python: logDropped() -> int
+   log records lost to a full ring since the last call
+   */
+static PyObject *
+TempControl_logDropped(PyObject *module, PyObject *args) {
+    return PyLong_FromUnsignedLong(logRing.takeDropped());
+}
+
+/*
+   python: enableStats(on=True)
+   */
+static PyObject *
+TempControl_enableStats(PyObject *module, PyObject *args, PyObject *kwds) {
+    int on = 1;
+    static const char *kwlist[] = {"on", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", (char **) kwlist, &on)) {
+        return NULL;
+    }
+    statsEnabled.store(on);
+    Py_RETURN_NONE;
+}
+
+/*
+   python: getStats(reset=False) -> {name: {count, min, max, mean, p50, p90, p99}}
+   times in microseconds, for every stage and method called
+   since timing was enabled
+   */
+static PyObject *
+TempControl_getStats(PyObject *module, PyObject *args, PyObject *kwds) {
+    try {
+        int reset = 0;
+        static const char *kwlist[] = {"reset", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", (char **) kwlist, &reset)) {
+            return NULL;
+        }
+        CPyObject stats(PyDict_New());
+        for(StageStats *s = StageStats::first.load(); s != nullptr; s = s->next) {
+            if(s->count.load() != 0) {
+                CPyObject stage(stageStatsToPy(*s));
+                if(PyDict_SetItemString(stats, s->name, stage) < 0) {
+                    return NULL;
+                }
+            }
+            if(reset) {
+                s->reset();
+            }
+        }
+        return stats.release();
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   Holds a one dimensional buffer of numbers of itemsize bytes,
+   with the stride counted in items
+   */
+class NumberBuffer {
+    public:
+        Py_buffer view;
+        ptrdiff_t stride;
+
+        NumberBuffer(PyObject *o, const char *formats, Py_ssize_t itemsize) {
+            if(PyObject_GetBuffer(o, &view, PyBUF_STRIDES | PyBUF_FORMAT) < 0) {
+                throw std::exception();
+            }
+            const char *format = view.format != NULL ? view.format : "B";
+            // skip byte order, native sizes are all that is accepted
+            if(*format == '@' || *format == '=' || *format == '<') {
+                format++;
+            }
+            if(view.ndim != 1 || view.itemsize != itemsize || strlen(format) != 1
+                    || strchr(formats, *format) == NULL || view.strides[0] % itemsize != 0) {
+                PyBuffer_Release(&view);
+                pyerr_printf("expected a one dimensional buffer of %s", formats);
+                throw std::exception();
+            }
+            stride = view.strides[0] / itemsize;
+        }
+
+        ~NumberBuffer() {
+            PyBuffer_Release(&view);
+        }
+
+        size_t size() const {
+            return view.shape[0];
+        }
+
+        NumberBuffer(const NumberBuffer &) = delete;
+        NumberBuffer& operator =(const NumberBuffer &) = delete;
+};
+
+// a memoryview of format over a new bytearray of n items
+static CPyObject
+newNumberArray(const char *format, size_t n, size_t itemsize, void **data) {
+    CPyObject bytes(PyByteArray_FromStringAndSize(NULL, n * itemsize));
+    *data = PyByteArray_AS_STRING((PyObject *) bytes);
+    CPyObject view(PyMemoryView_FromObject(bytes));
+    return CPyObject(PyObject_CallMethod(view, "cast", "s", format));
+}
+
+/*
+   python: tempsToUnit(temps, unit='c', diff=False) -> memoryview of doubles
+   converts a buffer of internal temperatures, eg a field of a
+   Recorder, int16 or for differences int16/int32.  Disconnected
+   readings become nan.
+   */
+static PyObject *
+TempControl_tempsToUnit(PyObject *module, PyObject *args, PyObject *kwds) {
+    try {
+        PyObject *temps;
+        int unit = 'c';
+        int diff = 0;
+        static const char *kwlist[] = {"temps", "unit", "diff", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|Cp", (char **) kwlist, &temps, &unit, &diff)) {
+            return NULL;
+        }
+        checkUnit(unit);
+        Py_buffer probe;
+        if(PyObject_GetBuffer(temps, &probe, PyBUF_STRIDES) < 0) {
+            return NULL;
+        }
+        Py_ssize_t itemsize = probe.itemsize;
+        PyBuffer_Release(&probe);
+        NumberBuffer in(temps, diff && itemsize == 4 ? "il" : "h", diff && itemsize == 4 ? 4 : 2);
+        void *out;
+        CPyObject result(newNumberArray("d", in.size(), sizeof(double), &out));
+        GILRelease nogil;
+        if(!diff) {
+            tempsToUnit(unit, (const int16_t *) in.view.buf, in.stride, (double *) out, in.size());
+        } else if(itemsize == 4) {
+            tempDiffsToUnit(unit, (const int32_t *) in.view.buf, in.stride, (double *) out, in.size());
+        } else {
+            tempDiffsToUnit(unit, (const int16_t *) in.view.buf, in.stride, (double *) out, in.size());
+        }
+        return result.release();
+    } catch(...) {
+        return NULL;
+    }
+}
+
+/*
+   python: unitsToTemps(values, unit='c') -> memoryview of int16
+   converts a buffer of doubles to internal temperatures, nan
+   becomes the disconnected value
+   */
+static PyObject *
+TempControl_unitsToTemps(PyObject *module, PyObject *args, PyObject *kwds) {
+    try {
+        PyObject *values;
+        int unit = 'c';
+        static const char *kwlist[] = {"values", "unit", NULL};
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|C", (char **) kwlist, &values, &unit)) {
+            return NULL;
+        }
+        checkUnit(unit);
+        NumberBuffer in(values, "d", sizeof(double));
+        void *out;
+        CPyObject result(newNumberArray("h", in.size(), sizeof(int16_t), &out));
+        GILRelease nogil;
+        unitsToTemps(unit, (const double *) in.view.buf, in.stride, (int16_t *) out, in.size());
+        return result.release();
+    } catch(...) {
+        return NULL;
+    }
+}
+
+static PyMethodDef TempControl_ModuleMethods[] = {
+    {"setClock", (PyCFunction) TempControl_setClock, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"advance", TempControl_advance, METH_VARARGS, NULL},
+    {"millis", TempControl_millis, METH_NOARGS, NULL},
+    {"drainLog", (PyCFunction) TempControl_drainLog, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"logDropped", TempControl_logDropped, METH_NOARGS, NULL},
+    {"enableStats", (PyCFunction) TempControl_enableStats, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"getStats", (PyCFunction) TempControl_getStats, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"tempsToUnit", (PyCFunction) TempControl_tempsToUnit, METH_VARARGS | METH_KEYWORDS, NULL},
+    {"unitsToTemps", (PyCFunction) TempControl_unitsToTemps, METH_VARARGS | METH_KEYWORDS, NULL},
+    {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+
+static struct PyModuleDef TempControl_Module = {
+    PyModuleDef_HEAD_INIT,
+    "TempControl",   /* name of module */
+    NULL, /* module documentation, may be NULL */
+    -1,       /* size of per-interpreter state of the module,
+                 or -1 if the module keeps state in global variables. */
+    TempControl_ModuleMethods
+};
+
+PyMODINIT_FUNC
+PyInit_TempControl(void)
+{
+    PyObject *module = PyModule_Create(&TempControl_Module);
+    if(module == NULL) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&TempControl_Type) < 0)
+        return NULL;
+    Py_INCREF(&TempControl_Type);
+
+    if (StateView_ready() < 0)
+        return NULL;
+    if (PyType_Ready(&Recorder_Type) < 0)
+        return NULL;
+    if (PyType_Ready(&TickAwaitable_Type) < 0)
+        return NULL;
+    if (PyType_Ready(&Scheduler_Type) < 0)
+        return NULL;
+    Py_INCREF(&Scheduler_Type);
 
     PyModule_AddObject(module, "TempControl", (PyObject *) &TempControl_Type);
+    PyModule_AddObject(module, "Scheduler", (PyObject *) &Scheduler_Type);
+
+    try {
+        CPyObject atexit(PyImport_ImportModule("atexit"));
+        CPyObject stopAll(PyCFunction_New(&stopAllSchedulersDef, NULL));
+        CPyObject registered(PyObject_CallMethod(atexit, "register", "O", (PyObject *) stopAll));
+    } catch(...) {
+        return NULL;
+    }
 
     PyModule_AddIntConstant(module, "MODE_FRIDGE_CONSTANT", MODE_FRIDGE_CONSTANT);
     PyModule_AddIntConstant(module, "MODE_BEER_CONSTANT", MODE_BEER_CONSTANT);
     PyModule_AddIntConstant(module, "MODE_BEER_PROFILE", MODE_BEER_PROFILE);
     PyModule_AddIntConstant(module, "MODE_OFF", MODE_OFF);
     PyModule_AddIntConstant(module, "MODE_TEST", MODE_TEST);
+    PyModule_AddIntConstant(module, "TEMP_CONTROL_STATIC", TEMP_CONTROL_STATIC);
 
     return module;
 }
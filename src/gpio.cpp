@@ -0,0 +1,109 @@
+/**
+  GPIO actuator, see gpio.h
+  */
+
+#include "gpio.h"
+#include <stdexcept>
+#include "utils.h"
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <linux/gpio.h>
+
+GpioActuator::GpioActuator(const char *path, bool activeLow) {
+    this->chardev = false;
+    this->activeLow = activeLow;
+    fd = open(path, O_WRONLY | O_CLOEXEC);
+    if(fd < 0) {
+        pyerr_printf("could not open gpio %s: %s", path, strerror(errno));
+        throw std::exception();
+    }
+    if(!write(false)) {
+        pyerr_printf("could not write gpio %s: %s", path, strerror(errno));
+        close(fd);
+        throw std::exception();
+    }
+}
+
+GpioActuator::GpioActuator(const char *chip, unsigned int line, bool activeLow) {
+    this->chardev = true;
+    this->activeLow = activeLow;
+    int chipFd = open(chip, O_RDONLY | O_CLOEXEC);
+    if(chipFd < 0) {
+        pyerr_printf("could not open gpio %s: %s", chip, strerror(errno));
+        throw std::exception();
+    }
+    // the kernel handles active low, and starts the line off
+    struct gpio_v2_line_request req;
+    memset(&req, 0, sizeof(req));
+    req.offsets[0] = line;
+    req.num_lines = 1;
+    strncpy(req.consumer, "brewpi", sizeof(req.consumer) - 1);
+    req.config.flags = GPIO_V2_LINE_FLAG_OUTPUT | (activeLow ? GPIO_V2_LINE_FLAG_ACTIVE_LOW : 0);
+    req.config.num_attrs = 1;
+    req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+    req.config.attrs[0].attr.values = 0;
+    req.config.attrs[0].mask = 1;
+    int r = ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, &req);
+    int err = errno;
+    close(chipFd);
+    if(r < 0) {
+        pyerr_printf("could not request line %u of %s: %s", line, chip, strerror(err));
+        throw std::exception();
+    }
+    fd = req.fd;
+    known = true;
+}
+
+GpioActuator::~GpioActuator() {
+    close(fd);
+}
+
+bool GpioActuator::write(bool active) {
+    if(chardev) {
+        struct gpio_v2_line_values values;
+        values.bits = active ? 1 : 0;
+        values.mask = 1;
+        if(ioctl(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0) {
+            return false;
+        }
+    } else {
+        const char *value = (active != activeLow) ? "1" : "0";
+        if(pwrite(fd, value, 1, 0) != 1) {
+            return false;
+        }
+    }
+    this->known = true;
+    this->active = active;
+    return true;
+}
+
+SwitchState GpioActuator::saveState() {
+    SwitchState state = {};
+    state.known = known;
+    state.active = active;
+    return state;
+}
+
+void GpioActuator::restoreState(const SwitchState &state) {
+    // a failed write leaves known false, setActive tries again
+    if(state.known && !write(state.active)) {
+        this->known = false;
+    }
+}
+
+void GpioActuator::setActive(bool active) {
+    if(this->known && this->active == active) {
+        return;
+    }
+    if(!write(active)) {
+        // write again next time, whatever the line is at now
+        this->known = false;
+        int err = errno;
+        GILAcquire gil;
+        pyerr_printf("could not switch gpio: %s", strerror(err));
+        throw std::exception();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+  An Actuator driving a linux GPIO line directly, so switching the
+  heater/cooler does not call into python.  The line is either
+
+    - a sysfs value file (/sys/class/gpio/gpioN/value) of a line
+      already exported and set to "out", or
+    - a line of a gpiochip character device (/dev/gpiochipN),
+      requested as an output for as long as the actuator lives
+
+  The line is switched off when the actuator is created and only
+  written when its state changes.
+  */
+
+#include "switchstate.h"
+
+class GpioActuator : public StatefulActuator {
+
+    private:
+        int fd = -1;
+        bool chardev;
+        bool activeLow;
+        bool known = false;
+        bool active = false;
+
+        bool write(bool active);
+
+    public:
+        // sysfs value file
+        GpioActuator(const char *path, bool activeLow);
+        // line of a gpiochip character device
+        GpioActuator(const char *chip, unsigned int line, bool activeLow);
+        ~GpioActuator();
+
+        void setActive(bool active);
+
+        bool isActive() {
+            return active;
+        }
+
+        SwitchState saveState();
+        // writes the line to the restored state, it was switched off on creation
+        void restoreState(const SwitchState &state);
+
+        GpioActuator(const GpioActuator &) = delete;
+        GpioActuator& operator =(const GpioActuator &) = delete;
+};
@@ -0,0 +1,81 @@
+/**
+  Log ring buffer, see logring.h
+  */
+
+#include "logring.h"
+#include <string.h>
+
+LogRing logRing;
+thread_local uint32_t logChamber = 0;
+
+LogRing::LogRing() : head(0), dropped(0) {
+    for(uint64_t n = 0; n < LOG_RING_SIZE; n++) {
+        slots[n].sequence.store(n, std::memory_order_relaxed);
+    }
+}
+
+void LogRing::push(char type, LOG_ID_TYPE id, const char *varTypes, va_list args) {
+    uint64_t pos = head.load(std::memory_order_relaxed);
+    Slot *slot;
+    for(;;) {
+        slot = &slots[pos & (LOG_RING_SIZE - 1)];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int64_t diff = (int64_t) sequence - (int64_t) pos;
+        if(diff == 0) {
+            if(head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if(diff < 0) {
+            // the reader has not freed this slot yet, the ring is full
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    LogRecord &r = slot->record;
+    r.time = millis();
+    r.chamber = logChamber;
+    r.type = type;
+    r.id = id;
+    r.argc = 0;
+    size_t used = 0;
+    for(const char *t = varTypes; *t != '\0' && r.argc < LOG_MAX_ARGS; t++) {
+        char kind = *t;
+        if(kind == 'd' || kind == 't') {
+            r.args[r.argc] = va_arg(args, int);
+        } else if(kind == 's') {
+            const char *s = va_arg(args, const char *);
+            size_t len = strnlen(s, LOG_MAX_TEXT);
+            if(used + len + 1 > LOG_MAX_TEXT) {
+                len = used < LOG_MAX_TEXT ? LOG_MAX_TEXT - used - 1 : 0;
+            }
+            if(used < LOG_MAX_TEXT) {
+                memcpy(r.text + used, s, len);
+                r.text[used + len] = '\0';
+                r.args[r.argc] = used;
+                used += len + 1;
+            } else {
+                // out of room, points at the last nul
+                r.args[r.argc] = LOG_MAX_TEXT - 1;
+            }
+        } else {
+            // can't know how to skip an unknown argument, stop here
+            break;
+        }
+        r.varTypes[r.argc++] = kind;
+    }
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+bool LogRing::pop(LogRecord &record) {
+    Slot *slot = &slots[tail & (LOG_RING_SIZE - 1)];
+    if(slot->sequence.load(std::memory_order_acquire) != tail + 1) {
+        return false;
+    }
+    record = slot->record;
+    slot->sequence.store(tail + LOG_RING_SIZE, std::memory_order_release);
+    tail++;
+    return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+/**
+  Logger::logMessageVaArg writes into a LogRing, a preallocated
+  ring of fixed size binary records, so the control loop can log
+  from any thread without allocating or taking the GIL.  Python
+  drains it with drainLog().
+
+  Records keep the message id and the raw arguments, turning them
+  into text (with the strings from LogMessages.h) is left to the
+  reader.  When the ring is full new records are dropped and
+  counted.
+
+  The ring is a bounded queue of sequence numbered slots: writers
+  claim a slot with a compare and swap on head and publish it by
+  bumping the slot's sequence, the reader only takes published
+  slots.  There is a single reader at a time, drainLog holds the
+  GIL.
+
+  Every record carries the id of the chamber it was logged for,
+  whichever chamber's lock the logging thread holds (see
+  ChamberLock), so one ring serves any number of chambers.
+  Records logged outside a chamber, including by replay and sweep
+  candidates, carry 0.
+  */
+
+#include "Logger.h"
+#include <atomic>
+#include <stdarg.h>
+
+#define LOG_RING_SIZE 1024
+#define LOG_MAX_ARGS 4
+#define LOG_MAX_TEXT 32
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+
+struct LogRecord {
+    unsigned long time;                 // millis()
+    uint32_t chamber;                   // TempControlRefs::id, 0 for none
+    char type;                          // 'I', 'W' or 'E'
+    LOG_ID_TYPE id;
+    uint8_t argc;
+    char varTypes[LOG_MAX_ARGS];        // 'd' int, 't' temperature, 's' string
+    int32_t args[LOG_MAX_ARGS];         // for 's' the offset into text
+    char text[LOG_MAX_TEXT];            // the strings, nul terminated, truncated to fit
+};
+
+class LogRing {
+    public:
+        LogRing();
+
+        void push(char type, LOG_ID_TYPE id, const char *varTypes, va_list args);
+
+        // false if there is nothing (published) to read
+        bool pop(LogRecord &record);
+
+        // records dropped because the ring was full, since the last call
+        unsigned long takeDropped() {
+            return dropped.exchange(0);
+        }
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> sequence;
+            LogRecord record;
+        };
+
+        Slot slots[LOG_RING_SIZE];
+        std::atomic<uint64_t> head;
+        uint64_t tail = 0;
+        std::atomic<unsigned long> dropped;
+};
+
+extern LogRing logRing;
+
+// the chamber this thread logs for
+extern thread_local uint32_t logChamber;
+
+// logs for chamber (0 for none) until it goes out of scope
+class LogChamberScope {
+    private:
+        uint32_t saved;
+
+    public:
+        LogChamberScope(uint32_t chamber) : saved(logChamber) {
+            logChamber = chamber;
+        }
+
+        ~LogChamberScope() {
+            logChamber = saved;
+        }
+
+        LogChamberScope(const LogChamberScope &) = delete;
+        LogChamberScope& operator =(const LogChamberScope &) = delete;
+};
@@ -0,0 +1,51 @@
+/**
+  Temperature profiles, see profile.h
+  */
+
+#include "profile.h"
+#include <algorithm>
+
+TempProfile::TempProfile(const std::vector<ProfilePoint> &points, bool step, unsigned long elapsed) :
+        points(points), step(step), start(0), last(elapsed) {
+}
+
+temperature TempProfile::at(unsigned long elapsed) const {
+    auto next = std::upper_bound(points.begin(), points.end(), elapsed,
+            [](unsigned long t, const ProfilePoint &p) { return t < p.time; });
+    if(next == points.begin()) {
+        return next->temp;
+    }
+    const ProfilePoint &prev = *(next - 1);
+    if(next == points.end() || step) {
+        return prev.temp;
+    }
+    long long span = next->time - prev.time;
+    long long delta = (long long) (next->temp - prev.temp) * (long long) (elapsed - prev.time);
+    return prev.temp + delta / span;
+}
+
+void TempProfile::apply(TempControl &tc) {
+    unsigned long now = millis();
+    if(!started) {
+        start = now - last;
+        started = true;
+    }
+    last = now - start;
+    temperature temp = at(last);
+    if(temp != tc.cs.beerSetting) {
+        tc.setBeerTemp(temp);
+    }
+}
+
+unsigned long TempProfile::elapsed() const {
+    return last;
+}
+
+void TempProfile::seek(unsigned long elapsed) {
+    started = false;
+    last = elapsed;
+}
+
+std::unique_ptr<TempProfile> TempProfile::resumed() const {
+    return std::unique_ptr<TempProfile>(new TempProfile(points, step, last));
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+/**
+  A beer temperature profile, followed natively in
+  MODE_BEER_PROFILE.  The profile is a list of points of time
+  (milliseconds into the profile) and beer setting, between
+  points the setting is interpolated linearly or held until the
+  next point (step).  Before the first point the first setting
+  holds, after the last point the last one.
+
+  Profile time starts at the first tick after the profile was
+  set, from whatever millis() is then, so a profile set before
+  simulate() or a replay runs on the simulated clock.
+  */
+
+#include "TempControl.h"
+#include <memory>
+#include <vector>
+
+struct ProfilePoint {
+    unsigned long time;
+    temperature temp;
+};
+
+class TempProfile {
+    public:
+        // points sorted by time, elapsed is where in the profile to start
+        TempProfile(const std::vector<ProfilePoint> &points, bool step, unsigned long elapsed);
+
+        // the beer setting elapsed milliseconds into the profile
+        temperature at(unsigned long elapsed) const;
+
+        /*
+           Sets the beer setting of tc for now, through setBeerTemp
+           so the controller reacts as to a setting from python, but
+           only when the setting changed
+           */
+        void apply(TempControl &tc);
+
+        // milliseconds into the profile as of the last apply
+        unsigned long elapsed() const;
+
+        // continues elapsed milliseconds into the profile from the next apply
+        void seek(unsigned long elapsed);
+
+        /*
+           A copy continuing from where this one is, for a replay or
+           sweep to follow on its own clock without moving this one
+           */
+        std::unique_ptr<TempProfile> resumed() const;
+
+        const std::vector<ProfilePoint> points;
+        const bool step;
+
+    private:
+        bool started = false;
+        unsigned long start;
+        unsigned long last;
+};
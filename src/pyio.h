@@ -0,0 +1,264 @@
+#pragma once
+
+/**
+  The python sensors and switches: BasicTempSensor and Actuator
+  implementations that call into python, taking the GIL only
+  around the call.
+  */
+
+#include "TempControl.h"
+#include "TempSensorBasic.h"
+#include "switchstate.h"
+#include "utils.h"
+#include "cpy.h"
+#include "stats.h"
+#include <stdexcept>
+
+/*
+   PyBasicTempSensor wraps a BasicTempSensor.  It calls
+   into python to find temperature data.
+
+   If read is a coroutine function the control loop never
+   calls it, read() returns the value tickAsync last awaited
+   and fed in.
+
+   python interface
+
+   class Sensor:
+
+       def read(unit=[c|f])
+
+       or
+
+       async def read(unit=[c|f])
+   
+   */
+class PyBasicTempSensor : public BasicTempSensor {
+
+    private:
+        CPyObject py_sensor;
+        // bound read method, looked up once
+        CPyObject py_read;
+
+        // ("unit",) and "c", created once and shared by every sensor
+        static PyObject *unitKwnames() {
+            static PyObject *kwnames = nullptr;
+            if(kwnames == nullptr) {
+                CPyObject unit(PyUnicode_InternFromString("unit"));
+                kwnames = PyTuple_Pack(1, (PyObject *) unit);
+                if(kwnames == nullptr) {
+                    throw std::exception();
+                }
+            }
+            return kwnames;
+        }
+
+        static PyObject *celsius() {
+            static PyObject *c = nullptr;
+            if(c == nullptr) {
+                c = PyUnicode_InternFromString("c");
+                if(c == nullptr) {
+                    throw std::exception();
+                }
+            }
+            return c;
+        }
+
+        bool async;
+        temperature fed = TEMP_SENSOR_DISCONNECTED;
+
+    public:
+        PyBasicTempSensor(CPyObject py_sensor) {
+            this->py_sensor = py_sensor;
+            this->py_read.reset(PyObject_GetAttrString(py_sensor, "read"));
+            this->async = isCoroutineFunction(this->py_read);
+            unitKwnames();
+            celsius();
+        }
+
+        PyObject *pyObject() const {
+            return this->py_sensor;
+        }
+
+        bool isAsync() const {
+            return this->async;
+        }
+
+        // calls read(unit='c'), for an async sensor that is the coroutine
+        PyObject *callRead() {
+            // slot 0 is scratch space for the callee, see PY_VECTORCALL_ARGUMENTS_OFFSET
+            PyObject *args[2] = {nullptr, celsius()};
+            return PyObject_Vectorcall(this->py_read, args + 1,
+                        0 | PY_VECTORCALL_ARGUMENTS_OFFSET, unitKwnames());
+        }
+
+        static temperature toTemp(PyObject *r) {
+            if(r == Py_None) {
+                return TEMP_SENSOR_DISCONNECTED;
+            }
+            return pyNumToTemp('c', r);
+        }
+
+        /*
+           the result of an awaited read, returned by read() from now on,
+           true if this connected a sensor that had nothing to read yet
+           */
+        bool feed(temperature temp) {
+            bool connected = this->fed == TEMP_SENSOR_DISCONNECTED && temp != TEMP_SENSOR_DISCONNECTED;
+            this->fed = temp;
+            return connected;
+        }
+
+        bool isConnected(void) {
+            return true;
+        }
+
+        bool init(void) {
+            return true;
+        }
+
+        temperature read() {
+            TIME_STAGE("sensor.read");
+            if(this->async) {
+                return this->fed;
+            }
+            GILAcquire gil;
+            CPyObject r(callRead());
+            return toTemp(r);
+        }
+
+};
+
+/*
+   PyActuator is a wrapper around actuator.  It calls into
+   python to set a switch on/off
+   The pthon class needs an on and off method
+
+   The last state written is remembered, python is only
+   called when the state actually changes, or when the
+   state has not been written for refresh milliseconds
+   (0 never refreshes).
+
+   If on and off are coroutine functions the control loop
+   only records the write, tickAsync awaits it afterwards.  The
+   state counts as written once that await finished, a write
+   that raised, was cancelled or never awaited is sent again.
+
+   python interface
+
+   class Switch:
+
+       def on()
+
+       def off()
+
+       or
+
+       async def on()
+
+       async def off()
+   
+   */
+class PyActuator : public StatefulActuator {
+
+    private:
+        CPyObject py_switch;
+        // bound on/off methods, looked up once
+        CPyObject py_on;
+        CPyObject py_off;
+
+        unsigned long refresh;
+        unsigned long lastWrite = 0;
+        bool known = false;
+        bool active = false;
+        bool async;
+        bool pending = false;
+        // the coroutine of a write was handed out, see writeDone
+        bool writing = false;
+
+    public:
+        PyActuator(CPyObject py_switch, unsigned long refresh) {
+            this->py_switch = py_switch;
+            this->py_on.reset(PyObject_GetAttrString(py_switch, "on"));
+            this->py_off.reset(PyObject_GetAttrString(py_switch, "off"));
+            this->refresh = refresh;
+            this->async = isCoroutineFunction(this->py_on) && isCoroutineFunction(this->py_off);
+        }
+
+        /*
+           For an async switch with a write outstanding, calls on()
+           or off() and returns the coroutine, otherwise NULL
+           */
+        PyObject *takePending() {
+            if(!this->pending) {
+                return NULL;
+            }
+            this->pending = false;
+            this->writing = true;
+            PyObject *m = this->active ? this->py_on : this->py_off;
+            PyObject *r = PyObject_Vectorcall(m, nullptr, 0, nullptr);
+            if(r == NULL) {
+                throw std::exception();
+            }
+            return r;
+        }
+
+        void setActive(bool active) {
+            TIME_STAGE("switch.setActive");
+            unsigned long now = millis();
+            if(this->known && this->active == active) {
+                if(this->refresh == 0 || now - this->lastWrite < this->refresh) {
+                    return;
+                }
+            }
+            if(this->async) {
+                // unknown until writeDone, so a lost write is retried
+                this->pending = true;
+                this->known = false;
+                this->active = active;
+                return;
+            }
+            {
+                GILAcquire gil;
+                PyObject *m = active ? this->py_on : this->py_off;
+                CPyObject r(PyObject_Vectorcall(m, nullptr, 0, nullptr));
+            }
+            this->known = true;
+            this->active = active;
+            this->lastWrite = now;
+        }
+
+        // the coroutine from takePending completed
+        void writeDone() {
+            if(this->writing) {
+                this->writing = false;
+                this->known = true;
+                this->lastWrite = millis();
+            }
+        }
+
+        bool isActive() {
+            return this->active;
+        }
+
+        bool isAsync() const {
+            return this->async;
+        }
+
+        SwitchState saveState() {
+            SwitchState state = {};
+            state.lastWrite = this->lastWrite;
+            state.known = this->known;
+            state.active = this->active;
+            return state;
+        }
+
+        // trusts the switch to still be where the snapshot left it
+        void restoreState(const SwitchState &state) {
+            this->lastWrite = state.lastWrite;
+            this->known = state.known;
+            this->active = state.active;
+            this->pending = false;
+        }
+
+};
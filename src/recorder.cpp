@@ -0,0 +1,38 @@
+/**
+  Per tick history, see recorder.h
+  */
+
+#include "recorder.h"
+#include "control.h"
+
+void Recorder::record(TempControl &tc, const TickResult &r) {
+    size_t n = records.size();
+    if(n == 0) {
+        return;
+    }
+    size_t index;
+    if(count < n) {
+        index = (start + count) % n;
+        count++;
+    } else {
+        index = start;
+        start = (start + 1) % n;
+    }
+
+    Record &rec = records[index];
+    rec.time = millis();
+    rec.beerTemp = tc.beerSensor->readFastFiltered();
+    rec.fridgeTemp = tc.fridgeSensor->readFastFiltered();
+    rec.beerSetting = tc.cs.beerSetting;
+    rec.fridgeSetting = tc.cs.fridgeSetting;
+    rec.beerDiff = tc.cv.beerDiff;
+    rec.beerSlope = tc.cv.beerSlope;
+    rec.diffIntegral = tc.cv.diffIntegral;
+    rec.p = tc.cv.p;
+    rec.i = tc.cv.i;
+    rec.d = tc.cv.d;
+    rec.state = r.newState;
+    rec.mode = tc.cs.mode;
+    rec.heater = tc.heater->isActive();
+    rec.cooler = tc.cooler->isActive();
+}
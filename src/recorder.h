@@ -0,0 +1,63 @@
+#pragma once
+
+/**
+  Recorder keeps the last capacity control ticks of a chamber in a
+  preallocated ring of fixed size records.  Nothing is allocated
+  while recording, and the records are laid out so python can map
+  them straight into numpy through the buffer protocol.
+
+  Temperatures are stored in the internal fixed point format,
+  unconverted.
+  */
+
+#include "TempControl.h"
+#include <vector>
+
+struct TickResult;
+
+struct Record {
+    int64_t time;           // millis()
+    int16_t beerTemp;
+    int16_t fridgeTemp;
+    int16_t beerSetting;
+    int16_t fridgeSetting;
+    int16_t beerDiff;
+    int16_t beerSlope;
+    int32_t diffIntegral;
+    int32_t p;
+    int32_t i;
+    int32_t d;
+    uint8_t state;
+    uint8_t mode;
+    uint8_t heater;
+    uint8_t cooler;
+};
+
+static_assert(sizeof(Record) == 40, "Record layout must match RECORD_FORMAT");
+
+// struct module / PEP 3118 description of Record
+#define RECORD_FORMAT "T{q:time:h:beerTemp:h:fridgeTemp:h:beerSetting:h:fridgeSetting:" \
+    "h:beerDiff:h:beerSlope:i:diffIntegral:i:p:i:i:i:d:" \
+    "B:state:B:mode:B:heater:B:cooler:}"
+
+class Recorder {
+    public:
+        Recorder(size_t capacity) : records(capacity), start(0), count(0) {
+        }
+
+        void record(TempControl &tc, const TickResult &r);
+
+        size_t capacity() const {
+            return records.size();
+        }
+
+        void clear() {
+            start = 0;
+            count = 0;
+        }
+
+        // records in ring order, the oldest is at start
+        std::vector<Record> records;
+        size_t start;
+        size_t count;
+};
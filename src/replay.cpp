@@ -0,0 +1,89 @@
+/**
+  Trace replay, see replay.h
+  */
+
+#include "replay.h"
+#include "utils.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+
+TraceFile::TraceFile(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        pyerr_printf("could not open trace %s: %s", path, strerror(errno));
+        throw std::exception();
+    }
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        pyerr_printf("could not stat trace %s: %s", path, strerror(errno));
+        close(fd);
+        throw std::exception();
+    }
+    if((size_t) st.st_size < sizeof(TraceHeader)) {
+        pyerr_printf("trace too short: %s", path);
+        close(fd);
+        throw std::exception();
+    }
+    size = st.st_size;
+    void *m = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(m == MAP_FAILED) {
+        pyerr_printf("could not map trace %s: %s", path, strerror(errno));
+        throw std::exception();
+    }
+    data = (const char *) m;
+    madvise(m, size, MADV_SEQUENTIAL);
+
+    const TraceHeader *header = (const TraceHeader *) data;
+    if(memcmp(header->magic, TRACE_MAGIC, 4) != 0 || header->version != TRACE_VERSION) {
+        munmap((void *) data, size);
+        pyerr_printf("not a version %d trace: %s", TRACE_VERSION, path);
+        throw std::exception();
+    }
+}
+
+TraceFile::~TraceFile() {
+    munmap((void *) data, size);
+}
+
+TracePlant::TracePlant(const TraceFile &trace) : trace(trace),
+        beer(TEMP_SENSOR_TYPE_BEER, &basicBeer), fridge(TEMP_SENSOR_TYPE_FRIDGE, &basicFridge) {
+}
+
+void TracePlant::seek(size_t n) {
+    const TraceSample &s = trace.samples()[n];
+    clock.setSimulated(s.time);
+    basicBeer.value = s.beerTemp;
+    basicFridge.value = s.fridgeTemp;
+}
+
+void TracePlant::attach(TempControl &tc) {
+    seek(0);
+    beer.init();
+    fridge.init();
+    tc.beerSensor = &beer;
+    tc.fridgeSensor = &fridge;
+    tc.heater = &heater;
+    tc.cooler = &cooler;
+    tc.initFilters();
+}
+
+void replayTrace(TempControlRefs &refs, const TraceFile &trace, std::vector<ReplayDecision> &decisions) {
+    size_t count = trace.count();
+    if(count == 0) {
+        return;
+    }
+    TracePlant plant(trace);
+    ClockScope scope(&plant.clock);
+    plant.attach(refs.controller());
+
+    decisions.reserve(decisions.size() + count);
+    for(size_t n = 0; n < count; n++) {
+        plant.seek(n);
+        TickResult r = refs.tick();
+        decisions.push_back({r.newState, plant.heater.isActive(), plant.cooler.isActive()});
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+/**
+  Replays a recorded trace of beer/fridge temperatures through a
+  chamber's controller, with millis() following the timestamps of
+  the trace, so recorded fermentations can be rerun against new
+  constants without calling into python per sample.
+
+  Trace file layout, little endian:
+
+      TraceHeader   magic "BPTR", version 1
+      TraceSample   repeated until the end of the file
+
+  Temperatures are in the internal fixed point format (as stored
+  by Recorder), INVALID_TEMP marks a disconnected sensor.
+  */
+
+#include "control.h"
+#include <vector>
+
+#define TRACE_MAGIC "BPTR"
+#define TRACE_VERSION 1
+
+struct TraceHeader {
+    char magic[4];
+    uint32_t version;
+};
+
+struct TraceSample {
+    uint32_t time;          // milliseconds since the start of the trace
+    int16_t beerTemp;
+    int16_t fridgeTemp;
+};
+
+// what the controller decided for one sample
+struct ReplayDecision {
+    uint8_t state;
+    uint8_t heater;
+    uint8_t cooler;
+};
+
+/*
+   A read only memory map of a trace file
+   */
+class TraceFile {
+    public:
+        TraceFile(const char *path);
+        ~TraceFile();
+
+        const TraceSample *samples() const {
+            return (const TraceSample *) (data + sizeof(TraceHeader));
+        }
+
+        size_t count() const {
+            return (size - sizeof(TraceHeader)) / sizeof(TraceSample);
+        }
+
+        TraceFile(const TraceFile &) = delete;
+        TraceFile& operator =(const TraceFile &) = delete;
+
+    private:
+        const char *data;
+        size_t size;
+};
+
+/*
+   BasicTempSensor returning whatever the replay last set
+   */
+class ReplayTempSensor : public BasicTempSensor {
+    public:
+        temperature value = TEMP_SENSOR_DISCONNECTED;
+
+        bool isConnected(void) {
+            return value != TEMP_SENSOR_DISCONNECTED;
+        }
+
+        bool init(void) {
+            return true;
+        }
+
+        temperature read() {
+            return value;
+        }
+};
+
+/*
+   A trace as the plant of a controller: sensors reading the
+   samples, a clock following their timestamps, and a heater and
+   cooler that only remember what the controller set.  Activate
+   the clock with a ClockScope before touching the controller.
+   */
+class TracePlant {
+    public:
+        TracePlant(const TraceFile &trace);
+
+        // points tc at the sensors and actuators, starting their filters at the first sample
+        void attach(TempControl &tc);
+
+        // moves the clock and the sensors to sample n
+        void seek(size_t n);
+
+        const TraceFile &trace;
+        Clock clock;
+        ReplayTempSensor basicBeer;
+        ReplayTempSensor basicFridge;
+        TempSensor beer;
+        TempSensor fridge;
+        ValueActuator heater;
+        ValueActuator cooler;
+
+        TracePlant(const TracePlant &) = delete;
+        TracePlant& operator =(const TracePlant &) = delete;
+};
+
+/*
+   Feeds every sample of trace through refs, which gets the
+   trace's sensors and a heater/cooler of its own.  refs is meant
+   to be a ScratchControl (see snapshot.h), the replay leaves it
+   in whatever state the trace drove it to.
+   */
+void replayTrace(TempControlRefs &refs, const TraceFile &trace, std::vector<ReplayDecision> &decisions);
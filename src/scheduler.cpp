@@ -0,0 +1,172 @@
+/**
+  Native scheduling, see scheduler.h
+  */
+
+#include "scheduler.h"
+#include <stdexcept>
+#include "utils.h"
+#include <cxxabi.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+static struct timespec toTimespec(uint64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+    return ts;
+}
+
+TickThread::TickThread(std::function<void(uint64_t)> cycle, uint64_t period) :
+        period(period), ticks(0), misses(0), errors(0), cycle(cycle), number(0) {
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if(timerFd < 0) {
+        pyerr_printf("could not create timer: %s", strerror(errno));
+        throw std::exception();
+    }
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if(stopFd < 0) {
+        pyerr_printf("could not create eventfd: %s", strerror(errno));
+        close(timerFd);
+        throw std::exception();
+    }
+    // the kernel keeps the deadlines, start + n * period
+    struct itimerspec spec;
+    next = monotonicNanos() + period;
+    spec.it_value = toTimespec(next);
+    spec.it_interval = toTimespec(period);
+    if(timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, NULL) < 0) {
+        pyerr_printf("could not set timer: %s", strerror(errno));
+        close(timerFd);
+        close(stopFd);
+        throw std::exception();
+    }
+    thread = std::thread(&TickThread::run, this);
+}
+
+TickThread::~TickThread() {
+    uint64_t one = 1;
+    if(write(stopFd, &one, sizeof(one)) != sizeof(one)) {
+        // can't happen for an eventfd below its maximum
+    }
+    thread.join();
+    close(timerFd);
+    close(stopFd);
+}
+
+void TickThread::resetStats() {
+    ticks.store(0);
+    misses.store(0);
+    errors.store(0);
+    latency.reset();
+    duration.reset();
+}
+
+void TickThread::run() {
+    PyThreadScope python;
+    struct pollfd fds[2] = {{timerFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+    for(;;) {
+        if(poll(fds, 2, -1) < 0) {
+            continue;
+        }
+        if(fds[1].revents != 0) {
+            return;
+        }
+        uint64_t expirations;
+        if(read(timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            continue;
+        }
+        uint64_t now = monotonicNanos();
+        // run for the latest deadline, the ones before it were missed
+        uint64_t deadline = next + (expirations - 1) * period;
+        next = deadline + period;
+        number += expirations;
+        misses.fetch_add(expirations - 1, std::memory_order_relaxed);
+        latency.record(now > deadline ? now - deadline : 0);
+        try {
+            cycle(number);
+        } catch(abi::__forced_unwind &) {
+            // the thread is being cancelled, not a failed cycle
+            throw;
+        } catch(...) {
+            errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        duration.record(monotonicNanos() - now);
+        ticks.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+TimerWheel::TimerWheel(uint64_t period, size_t slots) :
+        period(period), slots(slots), errors(0), wheel(slots) {
+}
+
+void TimerWheel::add(const void *key, std::function<void()> cycle) {
+    std::lock_guard<std::mutex> guard(lock);
+    for(Entry &e : entries) {
+        if(e.key == key) {
+            e.cycle = cycle;
+            return;
+        }
+    }
+    entries.push_back({key, cycle});
+    rebalance();
+}
+
+bool TimerWheel::remove(const void *key) {
+    std::lock_guard<std::mutex> guard(lock);
+    for(auto e = entries.begin(); e != entries.end(); e++) {
+        if(e->key == key) {
+            entries.erase(e);
+            rebalance();
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t TimerWheel::size() {
+    std::lock_guard<std::mutex> guard(lock);
+    return entries.size();
+}
+
+// entry n of count goes to slot n * slots / count, so they are as far apart as the slots allow
+void TimerWheel::rebalance() {
+    for(auto &slot : wheel) {
+        slot.clear();
+    }
+    for(size_t n = 0; n < entries.size(); n++) {
+        wheel[n * slots / entries.size()].push_back(n);
+    }
+}
+
+void TimerWheel::start() {
+    if(thread) {
+        return;
+    }
+    done = 0;
+    thread.reset(new TickThread([this](uint64_t number) {
+        run(number);
+    }, period / slots));
+}
+
+void TimerWheel::stop() {
+    thread.reset();
+}
+
+void TimerWheel::run(uint64_t number) {
+    std::lock_guard<std::mutex> guard(lock);
+    for(; done < number; done++) {
+        for(size_t n : wheel[done % slots]) {
+            try {
+                entries[n].cycle();
+            } catch(abi::__forced_unwind &) {
+                throw;
+            } catch(...) {
+                errors.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+/**
+  Native scheduling of the control cycle.  A TickThread calls
+  its cycle on a thread of its own at absolute deadlines, every
+  period nanoseconds from when it started, off a CLOCK_MONOTONIC
+  timerfd.  A slow cycle or a GC pause in a python sensor does
+  not shift the deadlines after it, deadlines that passed while
+  the cycle was still running are skipped and counted as misses.
+
+  latency is how late the thread woke for a deadline, duration how
+  long the cycle then ran.
+
+  A TimerWheel runs many cycles off one TickThread.  The period is
+  cut into slots, the thread wakes once per slot and runs the
+  cycles in it.  The cycles are spread evenly over the slots, so
+  with n chambers on a 1s period their sensor reads and switch
+  writes happen 1/n s apart instead of all at once.
+  */
+
+#include "stats.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+class TickThread {
+    public:
+        /*
+           starts the thread, the first cycle runs one period from now.
+           cycle gets the number of the deadline it runs for, counting
+           from 1, the numbers it skips were missed.
+           */
+        TickThread(std::function<void(uint64_t)> cycle, uint64_t period);
+
+        // stops the thread, waiting for a running cycle to finish
+        ~TickThread();
+
+        void resetStats();
+
+        const uint64_t period;
+        std::atomic<uint64_t> ticks;
+        std::atomic<uint64_t> misses;
+        // cycles that threw
+        std::atomic<uint64_t> errors;
+        StageStats latency;
+        StageStats duration;
+
+        TickThread(const TickThread &) = delete;
+        TickThread& operator =(const TickThread &) = delete;
+
+    private:
+        void run();
+
+        std::function<void(uint64_t)> cycle;
+        // the deadline the thread waits for next, and its number
+        uint64_t next;
+        uint64_t number;
+        int timerFd;
+        // written by the destructor to wake the thread
+        int stopFd;
+        std::thread thread;
+};
+
+class TimerWheel {
+    public:
+        TimerWheel(uint64_t period, size_t slots);
+
+        /*
+           Adds cycle under key, or replaces the cycle already under
+           it, and spreads all cycles over the slots again
+           */
+        void add(const void *key, std::function<void()> cycle);
+        // false if nothing was under key
+        bool remove(const void *key);
+        size_t size();
+
+        void start();
+        // returns once a running slot has finished
+        void stop();
+
+        const uint64_t period;
+        const size_t slots;
+        // cycles that threw
+        std::atomic<uint64_t> errors;
+        // while started, missed slots run late rather than not at all
+        std::unique_ptr<TickThread> thread;
+
+    private:
+        void rebalance();
+        void run(uint64_t number);
+
+        struct Entry {
+            const void *key;
+            std::function<void()> cycle;
+        };
+
+        // add, remove and the slots running are serialized by lock
+        std::mutex lock;
+        std::vector<Entry> entries;
+        // indexes into entries for every slot
+        std::vector<std::vector<size_t>> wheel;
+        // the last deadline run
+        uint64_t done = 0;
+};
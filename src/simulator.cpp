@@ -0,0 +1,33 @@
+/**
+  Thermal plant simulation, see simulator.h
+  */
+
+#include "simulator.h"
+
+// specific heat of water, J/(kg K)
+static const double BEER_SPECIFIC_HEAT = 4184.0;
+
+Simulator::Simulator(const PlantParams &params) : params(params) {
+    beerTemp = params.beerTemp;
+    fridgeTemp = params.fridgeTemp;
+    heating = false;
+    cooling = false;
+    time = 0;
+    clock.setSimulated(0);
+}
+
+void Simulator::step(double dt) {
+    double beerCapacity = params.beerMass * BEER_SPECIFIC_HEAT;
+    double beerFlow = params.beerTransfer * (fridgeTemp - beerTemp);
+    double roomFlow = params.roomTransfer * (params.roomTemp - fridgeTemp);
+    double power = roomFlow - beerFlow;
+    if(heating) {
+        power += params.heaterPower;
+    }
+    if(cooling) {
+        power -= params.coolerPower;
+    }
+    beerTemp += beerFlow * dt / beerCapacity;
+    fridgeTemp += power * dt / params.fridgeCapacity;
+    time += dt;
+}
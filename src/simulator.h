@@ -0,0 +1,127 @@
+#pragma once
+
+/**
+  A simple lumped thermal model of a fermentation chamber, used
+  to tune TempControl offline.  The beer and the fridge air are
+  each a single heat capacity, the beer exchanges heat with the
+  air, the air with the room, and the heater/cooler act on the
+  air.  Everything is in celsius, seconds, watts and joules.
+
+  SimTempSensor and SimActuator plug the model into TempControl
+  in place of the python sensors and switches, so a whole run
+  happens without calling into python.
+  */
+
+#include "TempControl.h"
+#include "clock.h"
+#include <vector>
+
+struct PlantParams {
+    double beerTemp = 20.0;
+    double fridgeTemp = 20.0;
+    double roomTemp = 20.0;
+    // kg of beer, treated as water
+    double beerMass = 20.0;
+    // J/K of the fridge air, walls and shelves
+    double fridgeCapacity = 20000.0;
+    // W
+    double heaterPower = 100.0;
+    double coolerPower = 150.0;
+    // W/K
+    double beerTransfer = 5.0;
+    double roomTransfer = 2.0;
+};
+
+// one recorded point of a simulation run
+struct SimSample {
+    double time;
+    double beerTemp;
+    double fridgeTemp;
+    unsigned char state;
+    bool heating;
+    bool cooling;
+};
+
+class Simulator {
+    public:
+        Simulator(const PlantParams &params);
+
+        // advance the plant by dt seconds
+        void step(double dt);
+
+        /*
+           Runs the plant and the controller together for duration
+           seconds, dt seconds per control tick, appending every
+           record'th tick to trajectory.  tick runs one control
+           cycle and returns its TickResult.  The simulator keeps its
+           own clock, millis() follows it while running.
+           */
+        template<class Tick>
+        void run(Tick tick, double duration, double dt, unsigned long record,
+                std::vector<SimSample> &trajectory) {
+            ClockScope scope(&clock);
+            unsigned long steps = duration / dt;
+            unsigned long start = clock.millis();
+            double elapsed = 0;
+            for(unsigned long n = 0; n < steps; n++) {
+                step(dt);
+                elapsed += dt;
+                // advance by whole milliseconds without accumulating rounding
+                clock.advance(start + (unsigned long)(elapsed * 1000) - clock.millis());
+                unsigned char state = tick().newState;
+                if(record != 0 && (n % record) == 0) {
+                    trajectory.push_back({time, beerTemp, fridgeTemp, state, heating, cooling});
+                }
+            }
+        }
+
+        PlantParams params;
+        double beerTemp;
+        double fridgeTemp;
+        bool heating;
+        bool cooling;
+        double time;
+        Clock clock;
+};
+
+class SimTempSensor : public BasicTempSensor {
+
+    private:
+        const double *value;
+
+    public:
+        SimTempSensor(const double *value) : value(value) {
+        }
+
+        bool isConnected(void) {
+            return true;
+        }
+
+        bool init(void) {
+            return true;
+        }
+
+        temperature read() {
+            return doubleToTemp(*value);
+        }
+
+};
+
+class SimActuator : public Actuator {
+
+    private:
+        bool *value;
+
+    public:
+        SimActuator(bool *value) : value(value) {
+        }
+
+        void setActive(bool active) {
+            *value = active;
+        }
+
+        bool isActive() {
+            return *value;
+        }
+
+};
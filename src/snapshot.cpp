@@ -0,0 +1,221 @@
+/**
+  Controller snapshots, see snapshot.h
+  */
+
+#include "snapshot.h"
+#include "switchstate.h"
+#include <stdexcept>
+#include "utils.h"
+#include <string.h>
+
+/*
+   Most of the state is private to TempControl and TempSensor.
+   Naming a private member in an explicit template instantiation
+   is allowed, Expose uses that to hand out a pointer to it.
+   */
+template<class Tag, typename Tag::type M>
+struct Expose {
+    friend typename Tag::type member(Tag) {
+        return M;
+    }
+};
+
+#define EXPOSE(cls, name, ptr) \
+    struct cls##_##name { \
+        typedef ptr type; \
+        friend type member(cls##_##name); \
+    }; \
+    template struct Expose<cls##_##name, &cls::name>;
+
+#if TEMP_CONTROL_STATIC
+#define EXPOSE_CONTROL(name, T) \
+    EXPOSE(TempControl, name, T *) \
+    static T &name(TempControl &tc) { return *member(TempControl_##name()); }
+#else
+#define EXPOSE_CONTROL(name, T) \
+    EXPOSE(TempControl, name, T TempControl::*) \
+    static T &name(TempControl &tc) { return tc.*member(TempControl_##name()); }
+#endif
+
+#define EXPOSE_SENSOR(name, T) \
+    EXPOSE(TempSensor, name, T TempSensor::*) \
+    static T &name(TempSensor &s) { return s.*member(TempSensor_##name()); }
+
+EXPOSE_CONTROL(storedBeerSetting, temperature)
+EXPOSE_CONTROL(lastIdleTime, uint16_t)
+EXPOSE_CONTROL(lastHeatTime, uint16_t)
+EXPOSE_CONTROL(lastCoolTime, uint16_t)
+EXPOSE_CONTROL(waitTime, uint16_t)
+EXPOSE_CONTROL(state, uint8_t)
+EXPOSE_CONTROL(doPosPeakDetect, bool)
+EXPOSE_CONTROL(doNegPeakDetect, bool)
+EXPOSE_CONTROL(doorOpen, bool)
+
+EXPOSE_SENSOR(fastFilter, TempSensorFilter)
+EXPOSE_SENSOR(slowFilter, TempSensorFilter)
+EXPOSE_SENSOR(slopeFilter, TempSensorFilter)
+EXPOSE_SENSOR(updateCounter, unsigned char)
+EXPOSE_SENSOR(prevOutputForSlope, temperature_precise)
+EXPOSE_SENSOR(failedReadCount, int8_t)
+
+// calls visit on every field of the snapshot, in blob order
+template<class Visit>
+static void visitState(TempControl &tc, Visit visit) {
+    visit(tc.cs);
+    visit(tc.cv);
+    visit(tc.cc);
+    visit(storedBeerSetting(tc));
+    visit(lastIdleTime(tc));
+    visit(lastHeatTime(tc));
+    visit(lastCoolTime(tc));
+    visit(waitTime(tc));
+    visit(state(tc));
+    visit(doPosPeakDetect(tc));
+    visit(doNegPeakDetect(tc));
+    visit(doorOpen(tc));
+    // a static controller has no sensors before init, keep the layout anyway
+    TempSensor unset(TEMP_SENSOR_TYPE_BEER);
+    for(TempSensor *sensor : {tc.beerSensor, tc.fridgeSensor}) {
+        TempSensor &s = sensor != nullptr ? *sensor : unset;
+        visit(fastFilter(s));
+        visit(slowFilter(s));
+        visit(slopeFilter(s));
+        visit(updateCounter(s));
+        visit(prevOutputForSlope(s));
+        visit(failedReadCount(s));
+    }
+}
+
+struct ChamberState {
+    SwitchState heater;
+    SwitchState cooler;
+    uint64_t profileElapsed;
+    uint8_t hasProfile;
+};
+
+static SwitchState saveSwitch(Actuator *actuator) {
+    StatefulActuator *stateful = dynamic_cast<StatefulActuator *>(actuator);
+    SwitchState state = {};
+    if(stateful != nullptr) {
+        state = stateful->saveState();
+    }
+    return state;
+}
+
+static void restoreSwitch(Actuator *actuator, const SwitchState &state) {
+    StatefulActuator *stateful = dynamic_cast<StatefulActuator *>(actuator);
+    if(stateful != nullptr) {
+        stateful->restoreState(state);
+    }
+}
+
+// the state of tc followed by extraSize bytes of extra
+static std::string pack(TempControl &tc, const void *extra, size_t extraSize) {
+    std::string blob(sizeof(SnapshotHeader), '\0');
+    visitState(tc, [&](auto &field) {
+        blob.append((const char *) &field, sizeof(field));
+    });
+    if(extraSize > 0) {
+        blob.append((const char *) extra, extraSize);
+    }
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.size = blob.size() - sizeof(SnapshotHeader);
+    memcpy(&blob[0], &header, sizeof(header));
+    return blob;
+}
+
+static void unpack(TempControl &tc, const std::string &blob, void *extra, size_t extraSize) {
+    size_t size = extraSize;
+    visitState(tc, [&](auto &field) {
+        size += sizeof(field);
+    });
+    SnapshotHeader header;
+    if(blob.size() >= sizeof(header)) {
+        memcpy(&header, blob.data(), sizeof(header));
+    }
+    if(blob.size() != sizeof(header) + size || memcmp(header.magic, SNAPSHOT_MAGIC, 4) != 0
+            || header.version != SNAPSHOT_VERSION || header.size != size) {
+        GILAcquire gil;
+        pyerr_printf("not a version %d snapshot of this build", SNAPSHOT_VERSION);
+        throw std::exception();
+    }
+    const char *p = blob.data() + sizeof(header);
+    visitState(tc, [&](auto &field) {
+        memcpy(&field, p, sizeof(field));
+        p += sizeof(field);
+    });
+    if(extraSize > 0) {
+        memcpy(extra, p, extraSize);
+    }
+}
+
+std::string snapshotControl(TempControl &tc) {
+    return pack(tc, nullptr, 0);
+}
+
+void restoreControl(TempControl &tc, const std::string &blob) {
+    unpack(tc, blob, nullptr, 0);
+}
+
+std::string snapshotChamber(TempControlRefs &refs) {
+    ChamberState chamber = {};
+    chamber.heater = saveSwitch(refs.heater.get());
+    chamber.cooler = saveSwitch(refs.cooler.get());
+    if(refs.profile) {
+        chamber.hasProfile = 1;
+        chamber.profileElapsed = refs.profile->elapsed();
+    }
+    return pack(refs.controller(), &chamber, sizeof(chamber));
+}
+
+void restoreChamber(TempControlRefs &refs, const std::string &blob) {
+    ChamberState chamber;
+    unpack(refs.controller(), blob, &chamber, sizeof(chamber));
+    restoreSwitch(refs.heater.get(), chamber.heater);
+    restoreSwitch(refs.cooler.get(), chamber.cooler);
+    if(refs.profile && chamber.hasProfile) {
+        refs.profile->seek(chamber.profileElapsed);
+    }
+}
+
+#if TEMP_CONTROL_STATIC
+ScratchControl::ScratchControl(TempControlRefs &chamber) : chamber(chamber) {
+    TempControl &tc = chamber.controller();
+    saved = snapshotControl(tc);
+    beerSensor = tc.beerSensor;
+    fridgeSensor = tc.fridgeSensor;
+    heater = tc.heater;
+    cooler = tc.cooler;
+    std::swap(recorder, chamber.recorder);
+    std::swap(changes, chamber.changes);
+    std::swap(profile, chamber.profile);
+    if(profile) {
+        chamber.profile = profile->resumed();
+    }
+}
+
+ScratchControl::~ScratchControl() {
+    TempControl &tc = chamber.controller();
+    tc.beerSensor = beerSensor;
+    tc.fridgeSensor = fridgeSensor;
+    tc.heater = heater;
+    tc.cooler = cooler;
+    // the filters are restored with the rest, through the sensor pointers
+    restoreControl(tc, saved);
+    std::swap(recorder, chamber.recorder);
+    std::swap(changes, chamber.changes);
+    std::swap(profile, chamber.profile);
+}
+#else
+ScratchControl::ScratchControl(TempControlRefs &chamber) {
+    restoreControl(scratch.controller(), snapshotControl(chamber.controller()));
+    if(chamber.profile) {
+        scratch.profile = chamber.profile->resumed();
+    }
+}
+
+ScratchControl::~ScratchControl() {
+}
+#endif
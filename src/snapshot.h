@@ -0,0 +1,96 @@
+#pragma once
+
+/**
+  Serializes everything a controller has learned while running:
+  cs, cv and cc, the state machine with its timers and peak
+  detection flags, and the filter histories of the beer and
+  fridge sensors.  A chamber snapshot adds what the heater and
+  cooler last wrote (see switchstate.h) and how far into its
+  profile the chamber is.  Restoring it into another process lets
+  that process take over a chamber without starting the filters
+  and PID from scratch.
+
+  Blob layout:
+
+      SnapshotHeader   magic "BPSN", version, size of the state
+      state            the fields in the order of visitState
+      ChamberState     chamber snapshots only
+
+  The profile points are not part of it, a chamber restored from
+  a snapshot taken while following a profile continues at the
+  same position in whatever profile it was given with setProfile.
+
+  Fields are stored raw, so a snapshot only restores into a
+  build with the same layout, which the size check catches in
+  practice.  The timers are in ticks, a process on the same host
+  (where millis() is the wall clock) picks up where this one left
+  off.
+  */
+
+#include "control.h"
+#include <string>
+
+#define SNAPSHOT_MAGIC "BPSN"
+#define SNAPSHOT_VERSION 2
+
+struct SnapshotHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t size;
+};
+
+std::string snapshotControl(TempControl &tc);
+
+// raises if blob is not a controller snapshot of this build
+void restoreControl(TempControl &tc, const std::string &blob);
+
+std::string snapshotChamber(TempControlRefs &refs);
+
+// raises if blob is not a chamber snapshot of this build
+void restoreChamber(TempControlRefs &refs, const std::string &blob);
+
+/*
+   A controller to run a replay or sweep candidate on, starting
+   from the state of a chamber and leaving the chamber as it was.
+   Without TEMP_CONTROL_STATIC it is a controller of its own.  The
+   static build only has the one controller, so there it is the
+   chamber's: the state, the sensor and actuator pointers and what
+   is attached to the chamber (recorder, change tracker, profile)
+   are set aside on construction and put back on destruction.
+   Either way the scratch controller follows a copy of the
+   chamber's profile, from where the chamber is in it.
+   Either way the caller holds the chamber's lock throughout, and
+   what the scratch controller logs is not tagged as the chamber's.
+   */
+class ScratchControl {
+    public:
+        ScratchControl(TempControlRefs &chamber);
+        ~ScratchControl();
+
+        TempControlRefs &refs() {
+#if TEMP_CONTROL_STATIC
+            return chamber;
+#else
+            return scratch;
+#endif
+        }
+
+        ScratchControl(const ScratchControl &) = delete;
+        ScratchControl& operator =(const ScratchControl &) = delete;
+
+    private:
+        LogChamberScope logScope{0};
+#if TEMP_CONTROL_STATIC
+        TempControlRefs &chamber;
+        std::string saved;
+        TempSensor *beerSensor;
+        TempSensor *fridgeSensor;
+        Actuator *heater;
+        Actuator *cooler;
+        std::shared_ptr<Recorder> recorder;
+        std::unique_ptr<ChangeTracker> changes;
+        std::unique_ptr<TempProfile> profile;
+#else
+        TempControlRefs scratch;
+#endif
+};
@@ -0,0 +1,88 @@
+/**
+  Stage timing, see stats.h
+  */
+
+#include "stats.h"
+#include <time.h>
+
+std::atomic<bool> statsEnabled(false);
+std::atomic<StageStats *> StageStats::first(nullptr);
+
+uint64_t monotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+   Values below 8 get a bucket each, above that every power of
+   two is split into 8 buckets, up to 2^40ns (18 minutes)
+   */
+static int bucketOf(uint64_t ns) {
+    if(ns < 8) {
+        return ns;
+    }
+    int e = 63 - __builtin_clzll(ns);
+    if(e > 40) {
+        return STATS_BUCKETS - 1;
+    }
+    return 8 + (e - 3) * 8 + ((ns >> (e - 3)) & 7);
+}
+
+uint64_t StageStats::bucketUpper(int bucket) {
+    if(bucket < 8) {
+        return bucket;
+    }
+    int e = (bucket - 8) / 8 + 3;
+    uint64_t sub = (bucket - 8) % 8;
+    return ((8 + sub + 1) << (e - 3)) - 1;
+}
+
+StageStats::StageStats(const char *name) : name(name) {
+    reset();
+    next = first.load();
+    while(!first.compare_exchange_weak(next, this)) {
+    }
+}
+
+StageStats::StageStats() : name(nullptr), next(nullptr) {
+    reset();
+}
+
+void StageStats::reset() {
+    count.store(0);
+    sum.store(0);
+    min.store(UINT64_MAX);
+    max.store(0);
+    for(auto &b : buckets) {
+        b.store(0);
+    }
+}
+
+void StageStats::record(uint64_t ns) {
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(ns, std::memory_order_relaxed);
+    buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t m = min.load(std::memory_order_relaxed);
+    while(ns < m && !min.compare_exchange_weak(m, ns, std::memory_order_relaxed)) {
+    }
+    m = max.load(std::memory_order_relaxed);
+    while(ns > m && !max.compare_exchange_weak(m, ns, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t StageStats::percentile(double p) const {
+    uint64_t total = 0;
+    for(auto &b : buckets) {
+        total += b.load(std::memory_order_relaxed);
+    }
+    uint64_t rank = p * total;
+    uint64_t seen = 0;
+    for(int n = 0; n < STATS_BUCKETS; n++) {
+        seen += buckets[n].load(std::memory_order_relaxed);
+        if(seen > rank) {
+            return bucketUpper(n);
+        }
+    }
+    return 0;
+}
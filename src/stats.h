@@ -0,0 +1,75 @@
+#pragma once
+
+/**
+  Optional timing of the control path.  A TIME_STAGE(name) at the
+  top of a function records how long every call took in the
+  StageStats for name, a histogram with 8 buckets per power of two
+  of nanoseconds (so percentiles are within 12.5%) plus count, sum,
+  min and max.  Everything is atomic, chambers on different threads
+  record into the same stats.
+
+  Timing is off until enableStats(), while off a TIME_STAGE costs a
+  relaxed load and a branch.
+  */
+
+#include <atomic>
+#include <stdint.h>
+
+#define STATS_BUCKETS 312
+
+class StageStats {
+    public:
+        StageStats(const char *name);
+        // a histogram of its own, not listed in getStats
+        StageStats();
+
+        void record(uint64_t ns);
+        void reset();
+
+        // upper bound of the bucket holding the p'th (0..1) fraction of calls
+        uint64_t percentile(double p) const;
+
+        static uint64_t bucketUpper(int bucket);
+
+        const char *name;
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> min;
+        std::atomic<uint64_t> max;
+        std::atomic<uint32_t> buckets[STATS_BUCKETS];
+
+        // all stats, newest first
+        static std::atomic<StageStats *> first;
+        StageStats *next;
+
+        StageStats(const StageStats &) = delete;
+        StageStats& operator =(const StageStats &) = delete;
+};
+
+extern std::atomic<bool> statsEnabled;
+
+uint64_t monotonicNanos();
+
+class StageTimer {
+    private:
+        StageStats &stats;
+        uint64_t start;
+
+    public:
+        StageTimer(StageStats &stats) : stats(stats) {
+            start = statsEnabled.load(std::memory_order_relaxed) ? monotonicNanos() : 0;
+        }
+
+        ~StageTimer() {
+            if(start != 0) {
+                stats.record(monotonicNanos() - start);
+            }
+        }
+
+        StageTimer(const StageTimer &) = delete;
+        StageTimer& operator =(const StageTimer &) = delete;
+};
+
+#define TIME_STAGE(name) \
+    static StageStats stageStats_(name); \
+    StageTimer stageTimer_(stageStats_)
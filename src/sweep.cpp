@@ -0,0 +1,172 @@
+/**
+  Parallel parameter sweep, see sweep.h
+  */
+
+#include "sweep.h"
+#include "utils.h"
+#include "snapshot.h"
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+/*
+   Accumulates the score of one run one tick at a time
+   */
+class SweepScorer {
+    private:
+        double setting;
+        double band;
+        // +1 when the beer starts above the setting, -1 below
+        double direction;
+        double sumSquares = 0;
+        unsigned long samples = 0;
+        double lastOutside = 0;
+        bool heating = false;
+        bool cooling = false;
+
+    public:
+        SweepScore score = {0, 0, 0, 0, 0};
+
+        SweepScorer(double setting, double band, double start) : setting(setting), band(band) {
+            direction = start >= setting ? 1 : -1;
+        }
+
+        void sample(double time, double beer, bool heating, bool cooling) {
+            double error = beer - setting;
+            sumSquares += error * error;
+            samples++;
+            score.overshoot = std::max(score.overshoot, -direction * error);
+            if(std::fabs(error) > band) {
+                lastOutside = time;
+            }
+            if(heating && !this->heating) {
+                score.heaterCycles++;
+            }
+            if(cooling && !this->cooling) {
+                score.coolerCycles++;
+            }
+            this->heating = heating;
+            this->cooling = cooling;
+        }
+
+        SweepScore result() {
+            score.settlingTime = lastOutside;
+            score.rmsError = samples ? std::sqrt(sumSquares / samples) : 0;
+            return score;
+        }
+};
+
+// the settings and constants a candidate starts from
+static void
+setupCandidate(TempControl &tc, const SweepSetup &setup, const ControlConstants &cc) {
+    tc.init();
+    tc.loadDefaultSettings();
+    tc.cc = cc;
+    tc.initFilters();
+    tc.setMode(setup.cs.mode);
+    tc.cs = setup.cs;
+}
+
+static SweepScore
+runSimulated(TempControlRefs &refs, const SweepSetup &setup, const ControlConstants &cc) {
+    Simulator sim(setup.plant);
+    SimTempSensor basicBeer(&sim.beerTemp);
+    SimTempSensor basicFridge(&sim.fridgeTemp);
+    TempSensor beer(TEMP_SENSOR_TYPE_BEER, &basicBeer);
+    TempSensor fridge(TEMP_SENSOR_TYPE_FRIDGE, &basicFridge);
+    SimActuator heater(&sim.heating);
+    SimActuator cooler(&sim.cooling);
+
+    // controller setup runs on the simulator's clock too
+    ClockScope scope(&sim.clock);
+    beer.init();
+    fridge.init();
+
+    TempControl &tc = refs.controller();
+    tc.beerSensor = &beer;
+    tc.fridgeSensor = &fridge;
+    tc.heater = &heater;
+    tc.cooler = &cooler;
+    setupCandidate(tc, setup, cc);
+
+    double setting = tempToDouble(setup.cs.beerSetting);
+    SweepScorer scorer(setting, setup.band, sim.beerTemp);
+    std::vector<SimSample> unused;
+    sim.run([&]() {
+        TickResult r = refs.tick();
+        scorer.sample(sim.time, sim.beerTemp, sim.heating, sim.cooling);
+        return r;
+    }, setup.duration, setup.dt, 0, unused);
+    return scorer.result();
+}
+
+static SweepScore
+runRecorded(TempControlRefs &refs, const SweepSetup &setup, const ControlConstants &cc) {
+    const TraceFile &trace = *setup.trace;
+    const TraceSample *samples = trace.samples();
+    TracePlant plant(trace);
+    ClockScope scope(&plant.clock);
+    TempControl &tc = refs.controller();
+    plant.attach(tc);
+    setupCandidate(tc, setup, cc);
+
+    double setting = tempToDouble(setup.cs.beerSetting);
+    SweepScorer scorer(setting, setup.band, tempToDouble(samples[0].beerTemp));
+    for(size_t n = 0; n < trace.count(); n++) {
+        double time = (samples[n].time - samples[0].time) / 1000.0;
+        if(setup.duration > 0 && time > setup.duration) {
+            break;
+        }
+        plant.seek(n);
+        refs.tick();
+        if(samples[n].beerTemp != INVALID_TEMP) {
+            scorer.sample(time, tempToDouble(samples[n].beerTemp),
+                    plant.heater.isActive(), plant.cooler.isActive());
+        }
+    }
+    return scorer.result();
+}
+
+static SweepScore
+runCandidate(TempControlRefs &refs, const SweepSetup &setup, const ControlConstants &cc) {
+    if(setup.trace != nullptr) {
+        return runRecorded(refs, setup, cc);
+    }
+    return runSimulated(refs, setup, cc);
+}
+
+#if TEMP_CONTROL_STATIC
+void runSweep(TempControlRefs &chamber, const SweepSetup &setup, const std::vector<ControlConstants> &cc,
+        unsigned threads, std::vector<SweepScore> &scores) {
+    scores.resize(cc.size());
+    for(size_t n = 0; n < cc.size(); n++) {
+        ScratchControl scratch(chamber);
+        scores[n] = runCandidate(scratch.refs(), setup, cc[n]);
+    }
+}
+#else
+void runSweep(TempControlRefs &chamber, const SweepSetup &setup, const std::vector<ControlConstants> &cc,
+        unsigned threads, std::vector<SweepScore> &scores) {
+    scores.resize(cc.size());
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for(size_t n = next++; n < cc.size(); n = next++) {
+            TempControlRefs refs;
+            if(setup.profile) {
+                refs.profile = setup.profile->resumed();
+            }
+            scores[n] = runCandidate(refs, setup, cc[n]);
+        }
+    };
+
+    threads = std::max(1u, std::min<unsigned>(threads, cc.size()));
+    std::vector<std::thread> pool;
+    for(unsigned n = 1; n < threads; n++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for(auto &t : pool) {
+        t.join();
+    }
+}
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+/**
+  Runs many candidate control constants against the same plant and
+  scores how well each held the beer at its setting.  The plant is
+  either simulated or a recorded trace.  A recorded plant does not
+  react to the candidate, the temperatures are those of the trace
+  whatever the candidate switched, so there only the heater and
+  cooler cycles tell candidates apart.
+
+  With TEMP_CONTROL_STATIC=0 every candidate gets an independent
+  controller and they are spread over a pool of threads.  The
+  static build has one controller, the candidates run one after
+  the other on the chamber's, through a ScratchControl.
+  */
+
+#include "control.h"
+#include "replay.h"
+#include <vector>
+
+struct SweepSetup {
+    PlantParams plant;
+    // the recorded plant, instead of plant if set
+    const TraceFile *trace = nullptr;
+    // settings every candidate starts from, mode and beer/fridge setting
+    ControlSettings cs;
+    // seconds to simulate and seconds per control tick, a trace
+    // runs until duration (all of it if 0) at its own ticks
+    double duration;
+    double dt;
+    // beer within band celsius of the setting counts as settled
+    double band;
+    /*
+       the chamber's profile, every candidate follows a copy of it
+       from where the chamber is; the static build's candidates get
+       theirs from ScratchControl
+       */
+    std::unique_ptr<TempProfile> profile;
+};
+
+struct SweepScore {
+    // furthest the beer went past the setting, celsius
+    double overshoot;
+    // seconds until the beer stayed within band, duration if it never did
+    double settlingTime;
+    // root mean square of beer temperature minus setting, celsius
+    double rmsError;
+    unsigned long coolerCycles;
+    unsigned long heaterCycles;
+};
+
+/*
+   Scores every candidate in cc, using up to threads threads.
+   scores is resized to match cc.  In the static build the caller
+   holds the lock of chamber, whose controller the candidates run
+   on, otherwise chamber is not touched.
+   */
+void runSweep(TempControlRefs &chamber, const SweepSetup &setup, const std::vector<ControlConstants> &cc,
+        unsigned threads, std::vector<SweepScore> &scores);
@@ -0,0 +1,23 @@
+#pragma once
+
+/**
+  What a switch last wrote.  A snapshot carries it over, so the
+  process taking over a chamber does not rewrite a line already
+  in the right state and keeps the refresh interval going.
+  */
+
+#include "Actuator.h"
+#include <stdint.h>
+
+struct SwitchState {
+    uint64_t lastWrite;     // millis() of the last write
+    uint8_t known;          // active is what the line is at
+    uint8_t active;
+};
+
+// an Actuator that hands out and takes back its SwitchState
+class StatefulActuator : public Actuator {
+    public:
+        virtual SwitchState saveState() = 0;
+        virtual void restoreState(const SwitchState &state) = 0;
+};
@@ -14,6 +14,7 @@
 #include <stdexcept>
 #include "cpy.h"
 #include "TemperatureFormats.h"
+#include "convert.h"
 
 /*
    It seems that the TempControl code has mostly
@@ -99,20 +100,30 @@ double unitToInternalDiff(char unit, double temp) {
     return f2c(temp + 32);
 }
 
+// these convert exactly, see convert.h
 temperature pyNumToTemp(char unit, PyObject *n) {
-    return doubleToTemp(unitToInternal(unit, pyNumToDouble(n)));
+    return unitToTemp(unit, pyNumToDouble(n));
 }
 
 temperature pyNumToTempDiff(char unit, PyObject *n) {
-    return doubleToTempDiff(unitToInternalDiff(unit, pyNumToDouble(n)));
+    return constrainTemp16(unitToTempDiff(unit, pyNumToDouble(n)));
+}
+
+// for the long_temperature fields of cv (diffIntegral, p, i, d)
+long_temperature pyNumToLongTempDiff(char unit, PyObject *n) {
+    return unitToTempDiff(unit, pyNumToDouble(n));
 }
 
 CPyObject tempToPyFloat(char unit, temperature t) {
-    return CPyObject(PyFloat_FromDouble(internalToUnit(unit, tempToDouble(t))));
+    return CPyObject(PyFloat_FromDouble(tempToUnit(unit, t)));
 }
 
 CPyObject tempDiffToPyFloat(char unit, temperature t) {
-    return CPyObject(PyFloat_FromDouble(internalDiffToUnit(unit, tempDiffToDouble(t))));
+    return CPyObject(PyFloat_FromDouble(tempDiffToUnit(unit, t)));
+}
+
+CPyObject longTempDiffToPyFloat(char unit, long_temperature t) {
+    return CPyObject(PyFloat_FromDouble(tempDiffToUnit(unit, t)));
 }
 
 void pyerr_printf(const char *format, ...) {
@@ -133,3 +144,16 @@ CPyObject getFromDict(PyObject *d, const char *key) {
     }
     return CPyObject(o, true);
 }
+
+bool isCoroutineFunction(PyObject *f) {
+    static PyObject *check = nullptr;
+    if(check == nullptr) {
+        CPyObject inspect(PyImport_ImportModule("inspect"));
+        check = PyObject_GetAttrString(inspect, "iscoroutinefunction");
+        if(check == nullptr) {
+            throw std::exception();
+        }
+    }
+    CPyObject r(PyObject_CallFunctionObjArgs(check, f, NULL));
+    return r == Py_True;
+}
@@ -32,18 +32,21 @@ temperature doubleToTempDiff(double f);
    */
 double pyNumToDouble(PyObject *pyNum);
 long pyNumToLong(PyObject *pyNum);
-/*
-   shortens a double, i was getting strange results
-   before i did this, don't care to investigate
-   */
-double shortenDouble(double v);
-double convertToTemp(char unit, double temp_c);
-double convertFromTemp(char unit, double temp);
-double convertToTempDiff(char unit, double temp_c);
-double convertFromTempDiff(char unit, double temp);
+double internalToUnit(char unit, double temp_c);
+double unitToInternal(char unit, double temp);
+double internalDiffToUnit(char unit, double temp_c);
+double unitToInternalDiff(char unit, double temp);
 void pyerr_printf(const char *format, ...);
 CPyObject getFromDict(PyObject *d, const char *key);
+/*
+   True if f is an async def function or method, those
+   sensors and switches are awaited by tickAsync instead
+   of being called from the control loop
+   */
+bool isCoroutineFunction(PyObject *f);
 temperature pyNumToTemp(char unit, PyObject *n);
 temperature pyNumToTempDiff(char unit, PyObject *n);
+long_temperature pyNumToLongTempDiff(char unit, PyObject *n);
 CPyObject tempToPyFloat(char unit, temperature t);
 CPyObject tempDiffToPyFloat(char unit, temperature t);
+CPyObject longTempDiffToPyFloat(char unit, long_temperature t);
@@ -0,0 +1,135 @@
+/**
+  w1 sysfs temperature sensor, see w1sensor.h
+  */
+
+#include "w1sensor.h"
+#include "Logger.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// what a DS18B20 reads before its first conversion, 85 degrees
+#define W1_POWER_ON_RAW 0x0550
+
+W1TempSensor::W1TempSensor(const char *path) : path(path) {
+    struct stat st;
+    if(stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+        this->path += "/w1_slave";
+    }
+    // the name of the directory w1_slave is in
+    std::string device = this->path.substr(0, this->path.rfind('/'));
+    address = device.substr(device.rfind('/') + 1);
+}
+
+W1TempSensor::~W1TempSensor() {
+    if(fd >= 0) {
+        close(fd);
+    }
+}
+
+bool W1TempSensor::open() {
+    if(fd < 0) {
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    return fd >= 0;
+}
+
+bool W1TempSensor::init(void) {
+    return open();
+}
+
+void W1TempSensor::setConnected(bool connected) {
+    if(this->connected == connected) {
+        return;
+    }
+    this->connected = connected;
+    // there is no pin behind sysfs, 0 stands in for it
+    if(connected) {
+        logInfoIntString(INFO_TEMP_SENSOR_CONNECTED, 0, address.c_str());
+    } else {
+        logWarningIntString(WARNING_TEMP_SENSOR_DISCONNECTED, 0, address.c_str());
+    }
+}
+
+temperature W1TempSensor::read() {
+    if(!open()) {
+        setConnected(false);
+        return TEMP_SENSOR_DISCONNECTED;
+    }
+    // sysfs runs a new conversion for every read from the start of the file
+    char buffer[128];
+    ssize_t len = pread(fd, buffer, sizeof(buffer), 0);
+    if(len <= 0) {
+        // the device went away, try opening it again next time
+        close(fd);
+        fd = -1;
+        setConnected(false);
+        return TEMP_SENSOR_DISCONNECTED;
+    }
+    temperature t = parseW1Slave(buffer, len);
+    setConnected(t != TEMP_SENSOR_DISCONNECTED);
+    return t;
+}
+
+uint8_t w1Crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+    for(size_t n = 0; n < len; n++) {
+        uint8_t b = data[n];
+        for(int bit = 0; bit < 8; bit++) {
+            uint8_t mix = (crc ^ b) & 0x01;
+            crc >>= 1;
+            if(mix) {
+                crc ^= 0x8C;
+            }
+            b >>= 1;
+        }
+    }
+    return crc;
+}
+
+static int hexDigit(char c) {
+    if(c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if(c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if(c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+temperature parseW1Slave(const char *text, size_t len) {
+    uint8_t scratchpad[9];
+    size_t pos = 0;
+    for(int n = 0; n < 9; n++) {
+        while(pos < len && text[pos] == ' ') {
+            pos++;
+        }
+        if(pos + 2 > len) {
+            return TEMP_SENSOR_DISCONNECTED;
+        }
+        int hi = hexDigit(text[pos]);
+        int lo = hexDigit(text[pos + 1]);
+        if(hi < 0 || lo < 0) {
+            return TEMP_SENSOR_DISCONNECTED;
+        }
+        scratchpad[n] = (hi << 4) | lo;
+        pos += 2;
+    }
+    if(w1Crc8(scratchpad, 8) != scratchpad[8]) {
+        return TEMP_SENSOR_DISCONNECTED;
+    }
+    // a shorted bus reads all zeros, which passes the crc
+    bool zero = true;
+    for(int n = 0; n < 9; n++) {
+        zero = zero && scratchpad[n] == 0;
+    }
+    int16_t raw = (int16_t) (scratchpad[0] | (scratchpad[1] << 8));
+    if(zero || raw == W1_POWER_ON_RAW) {
+        return TEMP_SENSOR_DISCONNECTED;
+    }
+    // raw is in 1/16 degrees
+    return constrainTemp16(long_temperature(raw) * (TEMP_FIXED_POINT_SCALE / 16) + C_OFFSET);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+/**
+  A BasicTempSensor reading a DS18B20 through the linux w1 sysfs
+  interface, so reading the beer/fridge temperature does not call
+  into python.  The kernel presents the sensor as
+
+      /sys/bus/w1/devices/28-xxxxxxxxxxxx/w1_slave
+
+  containing the 9 byte scratchpad twice, the second line ending
+  in the temperature:
+
+      72 01 4b 46 7f ff 0e 10 57 : crc=57 YES
+      72 01 4b 46 7f ff 0e 10 57 t=23125
+
+  The scratchpad itself is parsed and its crc checked here, the
+  raw reading (1/16 degree celsius) converts exactly into the
+  internal fixed point format.
+  */
+
+#include "TempSensorBasic.h"
+#include <stdint.h>
+#include <string>
+
+class W1TempSensor : public BasicTempSensor {
+
+    private:
+        std::string path;
+        // the device name, 28-xxxxxxxxxxxx, for the log
+        std::string address;
+        int fd = -1;
+        bool connected = false;
+
+        bool open();
+        // logs when the sensor comes or goes, as OneWireTempSensor does
+        void setConnected(bool connected);
+
+    public:
+        /*
+           path is either the device directory or the w1_slave
+           file in it
+           */
+        W1TempSensor(const char *path);
+        ~W1TempSensor();
+
+        bool isConnected(void) {
+            return connected;
+        }
+
+        bool init(void);
+        temperature read();
+
+        W1TempSensor(const W1TempSensor &) = delete;
+        W1TempSensor& operator =(const W1TempSensor &) = delete;
+};
+
+// dallas/maxim 1-wire crc8 of len bytes
+uint8_t w1Crc8(const uint8_t *data, size_t len);
+
+/*
+   Parses the contents of a w1_slave file, returns
+   TEMP_SENSOR_DISCONNECTED if it is malformed, the crc
+   does not match or the sensor reports its power on value
+   */
+temperature parseW1Slave(const char *text, size_t len);
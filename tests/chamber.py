@@ -0,0 +1,64 @@
+"""
+Fakes shared by the tests: python sensors and switches, and a
+chamber wired up to them.  Run the tests with make test.
+"""
+
+import struct
+import unittest
+
+import TempControl
+
+STATIC = TempControl.TEMP_CONTROL_STATIC
+
+# needs several TempControl objects alive at once
+multiChamber = unittest.skipIf(STATIC, "needs TEMP_CONTROL_STATIC=0")
+
+
+class Sensor:
+    def __init__(self, temp):
+        self.temp = temp
+
+    def read(self, unit=None):
+        return self.temp
+
+
+class Switch:
+    def __init__(self):
+        self.writes = []
+
+    def on(self):
+        self.writes.append(True)
+
+    def off(self):
+        self.writes.append(False)
+
+
+class Chamber:
+    """a TempControl with fake sensors and switches, initialized"""
+
+    def __init__(self, beer=20.0, fridge=20.0, unit='c'):
+        self.beer = Sensor(beer)
+        self.fridge = Sensor(fridge)
+        self.heater = Switch()
+        self.cooler = Switch()
+        self.tc = TempControl.TempControl(unit=unit)
+        self.tc.setBeerSensor(self.beer)
+        self.tc.setFridgeSensor(self.fridge)
+        self.tc.setHeater(self.heater)
+        self.tc.setCooler(self.cooler)
+        self.tc.init()
+        self.tc.loadDefaultSettings()
+        self.tc.loadDefaultConstants()
+
+
+def fixed(celsius):
+    """celsius in the internal fixed point format"""
+    return round(celsius * 512) - 48 * 512
+
+
+def writeTrace(path, samples):
+    """samples of (milliseconds, beer celsius, fridge celsius)"""
+    with open(path, 'wb') as f:
+        f.write(b'BPTR' + struct.pack('<I', 1))
+        for time, beer, fridge in samples:
+            f.write(struct.pack('<Ihh', time, fixed(beer), fixed(fridge)))
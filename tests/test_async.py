@@ -0,0 +1,117 @@
+import asyncio
+import gc
+import unittest
+import weakref
+
+import TempControl
+
+from chamber import Chamber
+
+
+class AsyncSensor:
+    def __init__(self, temp):
+        self.temp = temp
+
+    async def read(self, unit=None):
+        return self.temp
+
+
+class AsyncTest(unittest.TestCase):
+    def setUp(self):
+        self.chamber = Chamber()
+        self.tc = self.chamber.tc
+
+    def tearDown(self):
+        self.chamber = self.tc = None
+        gc.collect()
+
+    def testSyncTickRefusesAsyncSensor(self):
+        self.tc.setBeerSensor(AsyncSensor(20.0))
+        with self.assertRaises(ValueError):
+            self.tc.tick()
+
+    def testTickAsync(self):
+        self.tc.setBeerSensor(AsyncSensor(20.0))
+        asyncio.run(self._tick())
+
+    async def _tick(self):
+        await self.tc.tickAsync()
+
+    def testAwaitableCycleIsCollected(self):
+        sensor = AsyncSensor(20.0)
+        self.tc.setBeerSensor(sensor)
+        ref = asyncio.run(self._startAndDrop(sensor))
+        self.tc.setBeerSensor(AsyncSensor(20.0))
+        del sensor
+        gc.collect()
+        self.assertIsNone(ref())
+
+    async def _startAndDrop(self, sensor):
+        # start the reads and let them finish, but never resume the tick
+        tick = self.tc.tickAsync()
+        tick.send(None)
+        for _ in range(3):
+            await asyncio.sleep(0)
+        # tick -> its sensors -> sensor -> tick
+        sensor.tick = tick
+        return weakref.ref(sensor)
+
+
+class AsyncSwitch:
+    def __init__(self, failures=0):
+        self.writes = []
+        self.failures = failures
+
+    async def on(self):
+        self.writes.append(True)
+        if self.failures:
+            self.failures -= 1
+            raise OSError("relay did not answer")
+
+    async def off(self):
+        self.writes.append(False)
+
+
+class AsyncSwitchTest(unittest.TestCase):
+    def setUp(self):
+        # beer well above its setting, the chamber cools
+        self.chamber = Chamber(beer=25.0, fridge=25.0)
+        self.tc = self.chamber.tc
+        self.tc.setMode(TempControl.MODE_BEER_CONSTANT)
+        self.tc.setBeerTemp(c=20.0)
+
+    def tearDown(self):
+        self.chamber = self.tc = None
+
+    async def _tick(self):
+        return await self.tc.tickAsync()
+
+    def testWrittenOnce(self):
+        cooler = AsyncSwitch()
+        self.tc.setCooler(cooler)
+        for _ in range(3):
+            asyncio.run(self._tick())
+        self.assertEqual(cooler.writes.count(True), 1)
+
+    def testFailedWriteIsRetried(self):
+        cooler = AsyncSwitch(failures=1)
+        self.tc.setCooler(cooler)
+        with self.assertRaises(OSError):
+            asyncio.run(self._tick())
+        for _ in range(3):
+            asyncio.run(self._tick())
+        # the failed write, the retry, and nothing after it
+        self.assertEqual(cooler.writes.count(True), 2)
+
+    def testDroppedWriteIsRetried(self):
+        cooler = AsyncSwitch()
+        self.tc.setCooler(cooler)
+        asyncio.run(self._startAndClose())
+        asyncio.run(self._tick())
+        self.assertEqual(cooler.writes.count(True), 1)
+
+    async def _startAndClose(self):
+        # run the cycle, then drop the tick before its writes ran
+        tick = self.tc.tickAsync()
+        tick.send(None)
+        tick.close()
@@ -0,0 +1,60 @@
+import unittest
+
+from chamber import Chamber
+
+FIELDS = 19     # cs and cv fields, state, heater and cooler
+
+
+class ChangesTest(unittest.TestCase):
+    def setUp(self):
+        self.chamber = Chamber()
+        self.tc = self.chamber.tc
+
+    def tearDown(self):
+        self.chamber = self.tc = None
+
+    def testFirstCallGivesEverything(self):
+        token, fields = self.tc.changesSince()
+        self.assertNotEqual(token, 0)
+        self.assertEqual(len(fields), FIELDS)
+        self.assertIn('cs.beerSetting', fields)
+        self.assertIn('heater', fields)
+
+    def testUnchangedIsEmpty(self):
+        token, _ = self.tc.changesSince()
+        again, fields = self.tc.changesSince(token)
+        self.assertEqual(fields, {})
+        self.assertEqual(again, token)
+
+    def testSetterChange(self):
+        token, _ = self.tc.changesSince()
+        self.tc.setBeerTemp(c=18.5)
+        newer, fields = self.tc.changesSince(token)
+        self.assertGreater(newer, token)
+        self.assertEqual(fields['cs.beerSetting'], 18.5)
+        # only what moved
+        self.assertLess(len(fields), FIELDS)
+        self.assertEqual(self.tc.changesSince(newer)[1], {})
+
+    def testOlderTokenSeesLaterChanges(self):
+        first, _ = self.tc.changesSince()
+        self.tc.setBeerTemp(c=18.5)
+        self.tc.changesSince(first)
+        # a second poller still on the first token
+        _, fields = self.tc.changesSince(first)
+        self.assertIn('cs.beerSetting', fields)
+
+    def testStaleTokenGivesEverything(self):
+        token, _ = self.tc.changesSince()
+        _, fields = self.tc.changesSince(token + 1000)
+        self.assertEqual(len(fields), FIELDS)
+
+    def testLongFields(self):
+        token, _ = self.tc.changesSince()
+        cv = self.tc.getControlVariables()
+        cv['diffIntegral'] = 200.0
+        cv['p'] = -150.5
+        self.tc.setControlVariables(cv)
+        _, fields = self.tc.changesSince(token)
+        self.assertEqual(fields['cv.diffIntegral'], 200.0)
+        self.assertEqual(fields['cv.p'], -150.5)
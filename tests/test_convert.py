@@ -0,0 +1,73 @@
+import math
+import unittest
+from array import array
+
+import TempControl
+
+from chamber import Chamber, fixed
+
+INVALID = -32768
+
+
+class ConvertTest(unittest.TestCase):
+    def testInvalidIsNan(self):
+        values = TempControl.tempsToUnit(array('h', [INVALID, fixed(20.0)])).tolist()
+        self.assertTrue(math.isnan(values[0]))
+        self.assertEqual(values[1], 20.0)
+        temps = TempControl.unitsToTemps(array('d', [math.nan, 20.0])).tolist()
+        self.assertEqual(temps, [INVALID, fixed(20.0)])
+
+    def testFahrenheitRoundTrip(self):
+        # every temperature, INVALID_TEMP included, comes back as it went out
+        temps = array('h', range(-32768, 32768))
+        values = TempControl.tempsToUnit(temps, unit='f')
+        self.assertEqual(values[temps.index(fixed(20.0))], 68.0)
+        self.assertEqual(TempControl.unitsToTemps(values, unit='f').tolist(), temps.tolist())
+
+    def testStrided(self):
+        temps = memoryview(array('h', [fixed(20.0), 0, fixed(21.0), 0, fixed(22.0)]))[::2]
+        self.assertEqual(TempControl.tempsToUnit(temps).tolist(), [20.0, 21.0, 22.0])
+        values = memoryview(array('d', [20.0, 0.0, 21.5]))[::2]
+        self.assertEqual(TempControl.unitsToTemps(values).tolist(), [fixed(20.0), fixed(21.5)])
+
+    def testDiffs(self):
+        self.assertEqual(TempControl.tempsToUnit(array('h', [512, -256]), diff=True).tolist(), [1.0, -0.5])
+        # int32 for the long fields, beyond what an int16 holds
+        diffs = array('i', [200 * 512, -100 * 512])
+        self.assertEqual(TempControl.tempsToUnit(diffs, diff=True).tolist(), [200.0, -100.0])
+        self.assertEqual(TempControl.tempsToUnit(diffs, unit='f', diff=True).tolist(), [360.0, -180.0])
+
+
+class RecorderFieldTest(unittest.TestCase):
+    def setUp(self):
+        self.chamber = Chamber(beer=20.5, fridge=19.0)
+        self.tc = self.chamber.tc
+        self.recorder = self.tc.setRecorder(8)
+        for _ in range(5):
+            self.tc.tick()
+
+    def tearDown(self):
+        self.chamber = self.tc = self.recorder = None
+
+    def field(self, offset, format, size):
+        """one field of every record, a strided view into the ring"""
+        raw = memoryview(self.recorder).cast('B')
+        return raw[offset:len(raw) - (40 - offset - size)].cast(format)[::40 // size]
+
+    def testTemperatureField(self):
+        # beerTemp, after the int64 time
+        beer = self.field(8, 'h', 2)
+        self.assertEqual(len(beer), 8)
+        values = TempControl.tempsToUnit(beer).tolist()[:self.recorder.count]
+        self.assertEqual(values, [20.5] * 5)
+
+    def testDiffField(self):
+        # p, an int32
+        p = self.field(24, 'i', 4)
+        values = TempControl.tempsToUnit(p, diff=True).tolist()[:self.recorder.count]
+        expected = [self.tc.getControlVariables()['p']] * 5
+        self.assertEqual(values, expected)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,98 @@
+import os
+import struct
+import tempfile
+import unittest
+
+import TempControl
+
+from chamber import Chamber
+
+# an EepromBank header: magic, sequence, size, crc
+HEADER = struct.calcsize('<4sIII')
+SIZE = 1024
+
+
+class EepromTest(unittest.TestCase):
+    def setUp(self):
+        fd, self.path = tempfile.mkstemp(suffix='.eeprom')
+        os.close(fd)
+        os.unlink(self.path)
+        self.chamber = None
+
+    def tearDown(self):
+        self.chamber = None
+        if os.path.exists(self.path):
+            os.unlink(self.path)
+
+    def newChamber(self, size=SIZE):
+        # one at a time, so this runs in the static build too
+        self.chamber = None
+        self.chamber = Chamber()
+        tc = self.chamber.tc
+        tc.setEeprom(self.path, size=size)
+        return tc
+
+    def saved(self, beer, mode=TempControl.MODE_BEER_CONSTANT):
+        tc = self.newChamber()
+        # a fresh object reads its eeprom back, so its sequence carries on
+        tc.load()
+        tc.setMode(mode)
+        tc.setBeerTemp(c=beer)
+        tc.save()
+        return tc.getControlSettings(), tc.getControlConstants()
+
+    def corrupt(self, bank, offset):
+        with open(self.path, 'r+b') as f:
+            f.seek(bank * (HEADER + SIZE) + offset)
+            byte = f.read(1)
+            f.seek(-1, os.SEEK_CUR)
+            f.write(bytes([byte[0] ^ 0xff]))
+
+    def testRoundTrip(self):
+        settings, constants = self.saved(beer=17.5)
+        tc = self.newChamber()
+        self.assertNotEqual(tc.getControlSettings(), settings)
+        self.assertTrue(tc.load())
+        self.assertEqual(tc.getControlSettings(), settings)
+        self.assertEqual(tc.getControlConstants(), constants)
+
+    def testNewFile(self):
+        tc = self.newChamber()
+        before = tc.getControlSettings()
+        self.assertFalse(tc.load())
+        self.assertEqual(tc.getControlSettings(), before)
+
+    def testBadMagicFallsBack(self):
+        first, _ = self.saved(beer=17.5)
+        second, _ = self.saved(beer=19.0)
+        self.assertNotEqual(first, second)
+        # the first save went to bank 0, the second to bank 1
+        self.corrupt(bank=1, offset=0)
+        tc = self.newChamber()
+        self.assertTrue(tc.load())
+        self.assertEqual(tc.getControlSettings(), first)
+
+    def testBadCrcFallsBack(self):
+        first, _ = self.saved(beer=17.5)
+        self.saved(beer=19.0)
+        self.corrupt(bank=1, offset=HEADER + 4)
+        tc = self.newChamber()
+        self.assertTrue(tc.load())
+        self.assertEqual(tc.getControlSettings(), first)
+
+    def testBothBanksBad(self):
+        self.saved(beer=17.5)
+        self.saved(beer=19.0)
+        self.corrupt(bank=0, offset=HEADER + 4)
+        self.corrupt(bank=1, offset=HEADER + 4)
+        tc = self.newChamber()
+        self.assertFalse(tc.load())
+
+    def testOtherSizeIgnored(self):
+        self.saved(beer=17.5)
+        tc = self.newChamber(size=2 * SIZE)
+        self.assertFalse(tc.load())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,60 @@
+import unittest
+
+import TempControl
+
+from chamber import Chamber
+
+
+class GenerationTest(unittest.TestCase):
+    def setUp(self):
+        self.chamber = Chamber(beer=20.0, fridge=20.0)
+        self.tc = self.chamber.tc
+
+    def tearDown(self):
+        self.chamber = self.tc = None
+
+    def assertUnchanged(self, generation, settings, constants):
+        self.assertEqual(self.tc.generation(), generation)
+        self.assertIs(self.tc.getControlSettings(), settings)
+        self.assertIs(self.tc.getControlConstants(), constants)
+
+    def testPollingUnchanged(self):
+        generation = self.tc.generation()
+        settings = self.tc.getControlSettings()
+        constants = self.tc.getControlConstants()
+        self.assertUnchanged(generation, settings, constants)
+        # off, a tick moves no setting
+        self.tc.tick()
+        self.assertUnchanged(generation, settings, constants)
+
+    def testSetterBumps(self):
+        generation = self.tc.generation()
+        settings = self.tc.getControlSettings()
+        self.tc.setBeerTemp(c=18.5)
+        self.assertGreater(self.tc.generation(), generation)
+        changed = self.tc.getControlSettings()
+        self.assertIsNot(changed, settings)
+        self.assertEqual(changed['beerSetting'], 18.5)
+
+    def testRestoreBumps(self):
+        blob = self.tc.snapshot()
+        self.tc.setBeerTemp(c=18.5)
+        generation = self.tc.generation()
+        settings = self.tc.getControlSettings()
+        self.tc.restore(blob)
+        self.assertGreater(self.tc.generation(), generation)
+        self.assertIsNot(self.tc.getControlSettings(), settings)
+        self.assertEqual(self.tc.getControlSettings()['beerSetting'], 20.0)
+
+    def testTickMovingFridgeSettingBumps(self):
+        self.tc.setMode(TempControl.MODE_BEER_CONSTANT)
+        self.tc.setBeerTemp(c=18.0)
+        generation = self.tc.generation()
+        fridgeSetting = self.tc.getControlSettings()['fridgeSetting']
+        self.tc.tick()
+        self.assertNotEqual(self.tc.getControlSettings()['fridgeSetting'], fridgeSetting)
+        self.assertGreater(self.tc.generation(), generation)
+
+
+if __name__ == '__main__':
+    unittest.main()
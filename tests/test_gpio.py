@@ -0,0 +1,120 @@
+import glob
+import os
+import tempfile
+import unittest
+
+import TempControl
+
+from chamber import Chamber
+
+# a gpio-sim or gpio-mockup chip the tests may drive, never real hardware
+TEST_CHIP = os.environ.get('GPIO_TEST_CHIP')
+
+# TempControl's states, as getState() returns them
+COOLING = 4
+
+
+class SysfsTest(unittest.TestCase):
+    """against plain files standing in for /sys/class/gpio/gpioN/value"""
+
+    def setUp(self):
+        self.dir = tempfile.TemporaryDirectory()
+        self.heaterPath = self.value('heater')
+        self.coolerPath = self.value('cooler')
+        TempControl.setClock('simulated')
+        # beer well above its setting, so the chamber starts cooling
+        self.chamber = Chamber(beer=25.0, fridge=25.0)
+        self.tc = self.chamber.tc
+        self.tc.setMode(TempControl.MODE_BEER_CONSTANT)
+        self.tc.setBeerTemp(c=20.0)
+
+    def tearDown(self):
+        self.chamber = self.tc = None
+        TempControl.setClock('real')
+        self.dir.cleanup()
+
+    def value(self, name):
+        path = os.path.join(self.dir.name, name)
+        with open(path, 'w') as f:
+            f.write('x')
+        return path
+
+    def read(self, path):
+        with open(path) as f:
+            return f.read()
+
+    def setSwitches(self):
+        self.tc.setHeater(path=self.heaterPath)
+        self.tc.setCooler(path=self.coolerPath, activeLow=True)
+
+    def tickUntilCooling(self):
+        for _ in range(30):
+            self.tc.tick()
+            if self.tc.getState() == COOLING:
+                return
+            TempControl.advance(60000)
+        self.fail('chamber never started cooling')
+
+    def testStartsOff(self):
+        self.setSwitches()
+        self.assertEqual(self.read(self.heaterPath), '0')
+        # active low, off is a high line
+        self.assertEqual(self.read(self.coolerPath), '1')
+
+    def testActiveLow(self):
+        self.setSwitches()
+        self.tickUntilCooling()
+        self.assertEqual(self.read(self.coolerPath), '0')
+        self.assertEqual(self.read(self.heaterPath), '0')
+
+    def testWritesOnlyChanges(self):
+        self.setSwitches()
+        self.tickUntilCooling()
+        # anything written now would overwrite the marker
+        with open(self.coolerPath, 'w') as f:
+            f.write('x')
+        with open(self.heaterPath, 'w') as f:
+            f.write('x')
+        for _ in range(3):
+            self.tc.tick()
+        self.assertEqual(self.read(self.coolerPath), 'x')
+        self.assertEqual(self.read(self.heaterPath), 'x')
+
+    def testMissingValueFile(self):
+        with self.assertRaises(RuntimeError):
+            self.tc.setHeater(path=os.path.join(self.dir.name, 'nope'))
+
+
+class ChardevTest(unittest.TestCase):
+    def setUp(self):
+        self.chamber = Chamber()
+        self.tc = self.chamber.tc
+
+    def tearDown(self):
+        self.chamber = self.tc = None
+
+    def testArguments(self):
+        with self.assertRaises(RuntimeError):
+            self.tc.setHeater(chip='/dev/gpiochip0')
+        with self.assertRaises(RuntimeError):
+            self.tc.setHeater(chip='/dev/gpiochip0', line=1, path='/tmp/value')
+
+    def testMissingChip(self):
+        with self.assertRaises(RuntimeError):
+            self.tc.setHeater(chip='/nonexistent/gpiochip0', line=0)
+
+    def testNotAChip(self):
+        # the line request ioctl fails on anything but a gpiochip
+        with tempfile.NamedTemporaryFile() as f:
+            with self.assertRaises(RuntimeError):
+                self.tc.setHeater(chip=f.name, line=0)
+
+    @unittest.skipUnless(TEST_CHIP, "set GPIO_TEST_CHIP to a gpio-sim chip")
+    def testLine(self):
+        self.tc.setHeater(chip=TEST_CHIP, line=0)
+        self.tc.setCooler(chip=TEST_CHIP, line=1, activeLow=True)
+        for _ in range(3):
+            self.tc.tick()
+        # requesting a line twice fails while the actuator holds it
+        with self.assertRaises(RuntimeError):
+            self.tc.setHeater(chip=TEST_CHIP, line=1)
@@ -0,0 +1,83 @@
+import os
+import tempfile
+import unittest
+
+import TempControl
+
+from chamber import Chamber, multiChamber
+from test_w1sensor import scratchpad
+
+
+class LogTest(unittest.TestCase):
+    """a w1 sensor logs when it comes and goes, as the firmware's does"""
+
+    def setUp(self):
+        self.dir = tempfile.TemporaryDirectory()
+        self.chambers = []
+        TempControl.drainLog()
+
+    def tearDown(self):
+        self.chambers = None
+        self.dir.cleanup()
+
+    def w1Chamber(self, name):
+        """a chamber whose beer sensor is the w1 device name"""
+        device = os.path.join(self.dir.name, name)
+        os.mkdir(device)
+        self.write(name, scratchpad(20.0))
+        chamber = Chamber()
+        chamber.tc.setBeerSensor(path=device)
+        self.chambers.append(chamber)
+        return chamber.tc
+
+    def write(self, name, text):
+        with open(os.path.join(self.dir.name, name, 'w1_slave'), 'w') as f:
+            f.write(text)
+
+    def sensorRecords(self):
+        """(type, args, chamber) of the sensor records drained"""
+        return [(r[1], tuple(r[3]), r[4]) for r in TempControl.drainLog()
+                if len(r[3]) == 2 and str(r[3][1]).startswith('28-')]
+
+    def testConnectAndDisconnect(self):
+        tc = self.w1Chamber('28-000000000001')
+        tc.tick()
+        tc.tick()
+        chamber = tc.chamberId()
+        self.assertEqual(self.sensorRecords(), [('I', (0, '28-000000000001'), chamber)])
+        # a failed crc reads as disconnected
+        self.write('28-000000000001', scratchpad(20.0, crc=0))
+        tc.tick()
+        tc.tick()
+        self.assertEqual(self.sensorRecords(), [('W', (0, '28-000000000001'), chamber)])
+        self.write('28-000000000001', scratchpad(20.0))
+        tc.tick()
+        self.assertEqual(self.sensorRecords(), [('I', (0, '28-000000000001'), chamber)])
+
+    def testTaggedWithChamber(self):
+        tc = self.w1Chamber('28-000000000001')
+        tc.tick()
+        records = TempControl.drainLog()
+        self.assertTrue(records)
+        self.assertEqual({record[4] for record in records}, {tc.chamberId()})
+
+    @multiChamber
+    def testSeveralChambers(self):
+        a = self.w1Chamber('28-00000000000a')
+        b = self.w1Chamber('28-00000000000b')
+        self.assertNotEqual(a.chamberId(), b.chamberId())
+        a.tick()
+        b.tick()
+        self.sensorRecords()
+        self.write('28-00000000000a', scratchpad(20.0, crc=0))
+        self.write('28-00000000000b', scratchpad(20.0, crc=0))
+        b.tick()
+        a.tick()
+        self.assertEqual(self.sensorRecords(), [
+            ('W', (0, '28-00000000000b'), b.chamberId()),
+            ('W', (0, '28-00000000000a'), a.chamberId()),
+        ])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,71 @@
+import unittest
+
+import TempControl
+
+from chamber import Chamber
+
+POINTS = [(600, 19.0), (1200, 23.0)]
+
+
+class ProfileTest(unittest.TestCase):
+    def setUp(self):
+        TempControl.setClock('simulated')
+        self.chamber = Chamber()
+        self.tc = self.chamber.tc
+
+    def tearDown(self):
+        self.chamber = None
+        self.tc = None
+        TempControl.setClock('real')
+
+    def follow(self, step=False):
+        self.tc.setProfile(POINTS, step=step)
+        self.tc.setMode(TempControl.MODE_BEER_PROFILE)
+
+    def settingAt(self, seconds):
+        """ticks once the profile is seconds in and returns the beer setting"""
+        TempControl.advance(round((seconds - self.tc.getProfile()['elapsed']) * 1000))
+        self.tc.tick()
+        self.assertAlmostEqual(self.tc.getProfile()['elapsed'], seconds)
+        return self.tc.getControlSettings()['beerSetting']
+
+    def testInterpolated(self):
+        self.follow()
+        self.tc.tick()
+        self.assertAlmostEqual(self.settingAt(750), 20.0, places=2)
+        self.assertAlmostEqual(self.settingAt(900), 21.0, places=2)
+        self.assertAlmostEqual(self.settingAt(1050), 22.0, places=2)
+
+    def testStep(self):
+        self.follow(step=True)
+        self.tc.tick()
+        self.assertAlmostEqual(self.settingAt(900), 19.0, places=2)
+        self.assertAlmostEqual(self.settingAt(1199), 19.0, places=2)
+        self.assertAlmostEqual(self.settingAt(1200), 23.0, places=2)
+
+    def testBeforeFirstPoint(self):
+        self.follow()
+        self.tc.tick()
+        self.assertAlmostEqual(self.tc.getControlSettings()['beerSetting'], 19.0, places=2)
+        self.assertAlmostEqual(self.settingAt(300), 19.0, places=2)
+
+    def testAfterLastPoint(self):
+        self.follow()
+        self.tc.tick()
+        self.assertAlmostEqual(self.settingAt(1200), 23.0, places=2)
+        self.assertAlmostEqual(self.settingAt(36000), 23.0, places=2)
+
+    def testOnlyInProfileMode(self):
+        self.tc.setMode(TempControl.MODE_BEER_CONSTANT)
+        self.tc.setBeerTemp(c=18.0)
+        self.tc.setProfile(POINTS)
+        for _ in range(3):
+            self.tc.tick()
+            TempControl.advance(600000)
+        self.tc.tick()
+        self.assertAlmostEqual(self.tc.getControlSettings()['beerSetting'], 18.0, places=2)
+        self.assertEqual(self.tc.getProfile()['elapsed'], 0.0)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,64 @@
+import os
+import tempfile
+import unittest
+
+import TempControl
+from chamber import Chamber, writeTrace
+
+
+class ReplayTest(unittest.TestCase):
+    def setUp(self):
+        self.chamber = Chamber(beer=20.0, fridge=21.0)
+        self.tc = self.chamber.tc
+        self.tc.setMode(TempControl.MODE_BEER_CONSTANT)
+        self.tc.setBeerTemp(c=18.0)
+        fd, self.path = tempfile.mkstemp(suffix='.trace')
+        os.close(fd)
+        # a warm beer the controller has to cool, sampled every 10s for an hour
+        writeTrace(self.path, [(n * 10000, 24.0 - n * 0.01, 20.0 - n * 0.02) for n in range(360)])
+
+    def tearDown(self):
+        os.unlink(self.path)
+        # the static build only allows one chamber at a time
+        self.chamber = self.tc = None
+
+    def testChamberUnchanged(self):
+        for n in range(5):
+            self.tc.tick()
+        recorder = self.tc.setRecorder(16)
+        self.tc.tick()
+        token, _ = self.tc.changesSince()
+        self.tc.setProfile([(0, 18.0), (3600, 20.0)])
+        before = self.tc.snapshot()
+        count = recorder.count
+
+        decisions = self.tc.replay(self.path)
+
+        self.assertEqual(len(decisions), 360 * 3)
+        self.assertEqual(self.tc.snapshot(), before)
+        self.assertEqual(recorder.count, count)
+        self.assertEqual(self.tc.changesSince(token), (token, {}))
+        self.assertEqual(self.tc.getProfile()['elapsed'], 0.0)
+
+    def testFollowsProfile(self):
+        # the profile asks for a warm beer, the old setting for a cold one
+        self.tc.setBeerTemp(c=5.0)
+        self.tc.setProfile([(0, 30.0), (7200, 30.0)])
+        self.tc.setMode(TempControl.MODE_BEER_PROFILE)
+
+        decisions = self.tc.replay(self.path)
+
+        heater = decisions[1::3]
+        cooler = decisions[2::3]
+        self.assertTrue(any(heater))
+        self.assertFalse(any(cooler))
+        # the chamber's own profile and setting did not move
+        self.assertEqual(self.tc.getProfile()['elapsed'], 0.0)
+        self.assertEqual(self.tc.getControlSettings()['beerSetting'], 5.0)
+
+    def testRepeatable(self):
+        self.assertEqual(self.tc.replay(self.path), self.tc.replay(self.path))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,172 @@
+import time
+import unittest
+
+import TempControl
+
+from chamber import Chamber, Sensor, multiChamber
+
+
+class TimedSensor(Sensor):
+    """remembers when it was read"""
+
+    def __init__(self, temp):
+        super().__init__(temp)
+        self.reads = []
+
+    def read(self, unit=None):
+        self.reads.append(time.monotonic())
+        return self.temp
+
+
+class AsyncSensor(Sensor):
+    async def read(self, unit=None):
+        return self.temp
+
+
+def timedChamber():
+    chamber = Chamber()
+    chamber.beer = TimedSensor(20.0)
+    chamber.tc.setBeerSensor(chamber.beer)
+    return chamber
+
+
+class StartSchedulerTest(unittest.TestCase):
+    def setUp(self):
+        self.chamber = timedChamber()
+        self.tc = self.chamber.tc
+
+    def tearDown(self):
+        self.tc.stopScheduler()
+        self.chamber = self.tc = None
+
+    def testRuns(self):
+        self.tc.startScheduler(period=0.01)
+        time.sleep(0.2)
+        stats = self.tc.schedulerStats()
+        self.tc.stopScheduler()
+        self.assertTrue(stats['running'])
+        self.assertEqual(stats['period'], 0.01)
+        self.assertGreater(stats['ticks'], 0)
+        self.assertEqual(stats['errors'], 0)
+        for stage in ('latency', 'duration'):
+            self.assertGreater(stats[stage]['count'], 0)
+            self.assertGreater(stats[stage]['max'], 0)
+            self.assertGreater(stats[stage]['mean'], 0)
+        self.assertGreater(len(self.chamber.beer.reads), 0)
+        # and nothing is read once it stopped
+        reads = len(self.chamber.beer.reads)
+        time.sleep(0.05)
+        self.assertEqual(len(self.chamber.beer.reads), reads)
+        self.assertFalse(self.tc.schedulerStats()['running'])
+
+    def testPeriodRange(self):
+        with self.assertRaises(ValueError):
+            self.tc.startScheduler(period=0.0001)
+        with self.assertRaises(ValueError):
+            self.tc.startScheduler(period=1e6)
+
+    def testRefusesAsyncSensor(self):
+        self.tc.setBeerSensor(AsyncSensor(20.0))
+        with self.assertRaises(ValueError):
+            self.tc.startScheduler(period=0.01)
+        self.assertFalse(self.tc.schedulerStats()['running'])
+
+
+class SchedulerTest(unittest.TestCase):
+    def setUp(self):
+        self.chambers = []
+        self.scheduler = None
+
+    def tearDown(self):
+        if self.scheduler is not None:
+            self.scheduler.stop()
+        self.scheduler = None
+        self.chambers = []
+
+    def running(self, count, period, slots):
+        """a started scheduler with count timed chambers on it"""
+        self.scheduler = TempControl.Scheduler(period=period, slots=slots)
+        for _ in range(count):
+            chamber = timedChamber()
+            self.chambers.append(chamber)
+            self.scheduler.add(chamber.tc)
+        self.scheduler.start()
+        return self.scheduler
+
+    def testTicks(self):
+        scheduler = self.running(1, period=0.02, slots=2)
+        time.sleep(0.2)
+        stats = scheduler.stats()
+        self.assertTrue(stats['running'])
+        self.assertEqual(stats['chambers'], 1)
+        self.assertGreater(stats['ticks'], 0)
+        self.assertEqual(stats['errors'], 0)
+        self.assertGreater(len(self.chambers[0].beer.reads), 0)
+
+    def testRemoveStops(self):
+        scheduler = self.running(1, period=0.02, slots=2)
+        time.sleep(0.1)
+        beer = self.chambers[0].beer
+        scheduler.remove(self.chambers[0].tc)
+        reads = len(beer.reads)
+        self.assertGreater(reads, 0)
+        time.sleep(0.1)
+        self.assertEqual(len(beer.reads), reads)
+        self.assertEqual(scheduler.stats()['chambers'], 0)
+
+    @multiChamber
+    def testRemoveKeepsOthers(self):
+        scheduler = self.running(2, period=0.02, slots=2)
+        time.sleep(0.1)
+        kept, removed = self.chambers
+        scheduler.remove(removed.tc)
+        reads = len(kept.beer.reads), len(removed.beer.reads)
+        time.sleep(0.1)
+        self.assertGreater(len(kept.beer.reads), reads[0])
+        self.assertEqual(len(removed.beer.reads), reads[1])
+
+    @multiChamber
+    def testStaggered(self):
+        # two chambers on four slots run half a period apart
+        scheduler = self.running(2, period=0.2, slots=4)
+        time.sleep(1.0)
+        scheduler.stop()
+        first, second = (c.beer.reads for c in self.chambers)
+        self.assertGreater(len(first), 2)
+        self.assertGreater(len(second), 2)
+        gaps = [min(abs(t - u) for u in second) for t in first]
+        # 0.1s apart when on time, close together if not staggered at all
+        self.assertGreater(sorted(gaps)[len(gaps) // 2], 0.05)
+
+
+class UninitializedSchedulerTest(unittest.TestCase):
+    def setUp(self):
+        self.chamber = Chamber()
+
+    def tearDown(self):
+        self.chamber = None
+
+    def assertUnusable(self, scheduler):
+        with self.assertRaises(RuntimeError):
+            scheduler.add(self.chamber.tc)
+        with self.assertRaises(RuntimeError):
+            scheduler.remove(self.chamber.tc)
+        with self.assertRaises(RuntimeError):
+            scheduler.start()
+        with self.assertRaises(RuntimeError):
+            scheduler.stop()
+        with self.assertRaises(RuntimeError):
+            scheduler.stats()
+
+    def testNewWithoutInit(self):
+        self.assertUnusable(TempControl.Scheduler.__new__(TempControl.Scheduler))
+
+    def testFailedInit(self):
+        scheduler = TempControl.Scheduler.__new__(TempControl.Scheduler)
+        with self.assertRaises(ValueError):
+            scheduler.__init__(slots=0)
+        self.assertUnusable(scheduler)
+        # and a later __init__ that succeeds makes it usable
+        scheduler.__init__(period=1.0, slots=2)
+        self.assertFalse(scheduler.stats()['running'])
+        self.assertEqual(scheduler.stats()['chambers'], 0)
@@ -0,0 +1,77 @@
+import unittest
+
+import TempControl
+
+from chamber import Chamber
+
+PROFILE = [(0, 20.0), (3600, 18.0)]
+
+
+class SnapshotTest(unittest.TestCase):
+    def setUp(self):
+        TempControl.setClock('simulated')
+        self.chamber = None
+
+    def tearDown(self):
+        self.chamber = None
+        TempControl.setClock('real')
+
+    def newChamber(self):
+        # one at a time, so this runs in the static build too
+        self.chamber = None
+        self.chamber = Chamber(beer=25.0, fridge=25.0)
+        tc = self.chamber.tc
+        tc.setProfile(PROFILE)
+        tc.setMode(TempControl.MODE_BEER_PROFILE)
+        return tc
+
+    def taken(self):
+        """a snapshot of a chamber that has switched and is into its profile"""
+        tc = self.newChamber()
+        for _ in range(10):
+            tc.tick()
+            TempControl.advance(60000)
+        tc.tick()
+        self.assertGreater(tc.getProfile()['elapsed'], 0)
+        return tc.snapshot(), tc.getProfile()['elapsed'], list(self.chamber.cooler.writes)
+
+    def testRoundTrip(self):
+        blob, elapsed, _ = self.taken()
+        tc = self.newChamber()
+        tc.restore(blob)
+        self.assertEqual(tc.snapshot(), blob)
+        self.assertEqual(tc.getProfile()['elapsed'], elapsed)
+
+    def testSwitchesCarryOver(self):
+        blob, _, writes = self.taken()
+        self.assertTrue(writes)
+        tc = self.newChamber()
+        tc.restore(blob)
+        tc.tick()
+        # the new switch was told what the old one last wrote, so
+        # holding that state writes nothing
+        if writes[-1]:
+            self.assertNotIn(True, self.chamber.cooler.writes)
+        else:
+            self.assertNotIn(False, self.chamber.cooler.writes)
+
+    def testProfileContinues(self):
+        blob, elapsed, _ = self.taken()
+        tc = self.newChamber()
+        tc.restore(blob)
+        # picks up where the snapshot was taken, however long ago
+        TempControl.advance(600000)
+        tc.tick()
+        self.assertEqual(tc.getProfile()['elapsed'], elapsed)
+        TempControl.advance(60000)
+        tc.tick()
+        self.assertEqual(tc.getProfile()['elapsed'], elapsed + 60.0)
+
+    def testRejectsOtherVersions(self):
+        blob, _, _ = self.taken()
+        # the version follows the magic, little endian
+        old = blob[:4] + bytes([1, 0]) + blob[6:]
+        with self.assertRaises(RuntimeError):
+            self.chamber.tc.restore(old)
+        with self.assertRaises(RuntimeError):
+            self.chamber.tc.restore(blob[:-1])
@@ -0,0 +1,75 @@
+import os
+import tempfile
+import unittest
+
+import TempControl
+from chamber import Chamber, writeTrace
+
+
+class SweepTest(unittest.TestCase):
+    def setUp(self):
+        self.chamber = Chamber(beer=22.0, fridge=22.0)
+        self.tc = self.chamber.tc
+        self.tc.setMode(TempControl.MODE_BEER_CONSTANT)
+        self.tc.setBeerTemp(c=18.0)
+        for n in range(3):
+            self.tc.tick()
+
+    def tearDown(self):
+        self.chamber = self.tc = None
+
+    def testSimulated(self):
+        self.tc.setSimulator(beerTemp=22, fridgeTemp=22)
+        before = self.tc.snapshot()
+        results = self.tc.sweep(600, candidates=[{'Kp': 5.0}, {'Kp': 10.0}], threads=2)
+        self.assertEqual([r['constants'] for r in results], [{'Kp': 5.0}, {'Kp': 10.0}])
+        for r in results:
+            self.assertGreaterEqual(r['rmsError'], 0)
+        self.assertEqual(self.tc.snapshot(), before)
+
+    def testRecorded(self):
+        fd, path = tempfile.mkstemp(suffix='.trace')
+        os.close(fd)
+        try:
+            writeTrace(path, [(n * 10000, 22.0 - n * 0.01, 20.0) for n in range(100)])
+            before = self.tc.snapshot()
+            results = self.tc.sweep(ranges={'Kp': (2.0, 10.0)}, samples=3, seed=1, trace=path)
+            self.assertEqual(len(results), 3)
+            # the plant is the trace whatever the candidate does
+            self.assertEqual(len({r['rmsError'] for r in results}), 1)
+            self.assertAlmostEqual(results[0]['overshoot'], 0)
+            self.assertEqual(self.tc.snapshot(), before)
+            # duration cuts the trace short
+            short = self.tc.sweep(100, candidates=[{}], trace=path)[0]
+            self.assertLess(short['settlingTime'], results[0]['settlingTime'])
+        finally:
+            os.unlink(path)
+
+    def testFollowsProfile(self):
+        fd, path = tempfile.mkstemp(suffix='.trace')
+        os.close(fd)
+        try:
+            writeTrace(path, [(n * 10000, 22.0, 20.0) for n in range(100)])
+            # at 18 degrees the chamber only cools
+            plain = self.tc.sweep(candidates=[{}], trace=path)[0]
+            self.assertEqual(plain['heaterCycles'], 0)
+            self.tc.setProfile([(0, 30.0)])
+            self.tc.setMode(TempControl.MODE_BEER_PROFILE)
+            warm = self.tc.sweep(candidates=[{}], trace=path)[0]
+            self.assertGreater(warm['heaterCycles'], 0)
+            self.assertEqual(self.tc.getProfile()['elapsed'], 0.0)
+        finally:
+            os.unlink(path)
+
+    def testNoPlant(self):
+        with self.assertRaises(RuntimeError):
+            self.tc.sweep(600, candidates=[{}])
+
+    def testOnlyConstants(self):
+        self.tc.setSimulator()
+        with self.assertRaises(RuntimeError):
+            self.tc.sweep(600, candidates=[{'beerSetting': 20.0}])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,52 @@
+import unittest
+
+from chamber import Chamber
+
+# beyond the int16 range of a temperature, 64 degrees and up
+LONG = {'diffIntegral': 200.0, 'p': -150.5, 'i': 99.998046875, 'd': 1000.0}
+
+
+class ControlVariablesTest(unittest.TestCase):
+    def setUp(self):
+        self.chamber = Chamber()
+        self.tc = self.chamber.tc
+
+    def tearDown(self):
+        self.chamber = self.tc = None
+
+    def testLongFieldsRoundTrip(self):
+        cv = self.tc.getControlVariables()
+        cv.update(LONG)
+        self.tc.setControlVariables(cv)
+        got = self.tc.getControlVariables()
+        for name, value in LONG.items():
+            self.assertEqual(got[name], value, name)
+
+    def testLongFieldsInView(self):
+        cv = self.tc.getControlVariables()
+        cv.update(LONG)
+        self.tc.setControlVariables(cv)
+        view = self.tc.getStateView()
+        for name, value in LONG.items():
+            self.assertEqual(getattr(view, name), value, name)
+
+    def testShortFieldsClamp(self):
+        cv = self.tc.getControlVariables()
+        cv['beerDiff'] = 200.0
+        self.tc.setControlVariables(cv)
+        # beerDiff is a 16 bit temperature
+        self.assertLess(self.tc.getControlVariables()['beerDiff'], 64.0)
+
+    def testRoundTrip(self):
+        cv = self.tc.getControlVariables()
+        cv.update(beerDiff=1.5, beerSlope=-0.25, negPeak=2.0)
+        self.tc.setControlVariables(cv)
+        self.assertEqual(self.tc.getControlVariables(), cv)
+
+    def testMissingFieldChangesNothing(self):
+        before = self.tc.getControlVariables()
+        cv = dict(before, beerDiff=1.5)
+        del cv['posPeak']
+        with self.assertRaises(RuntimeError):
+            self.tc.setControlVariables(cv)
+        self.assertEqual(self.tc.getControlVariables(), before)
@@ -0,0 +1,84 @@
+import os
+import struct
+import tempfile
+import unittest
+
+import TempControl
+
+from chamber import Chamber, fixed
+
+
+def crc8(data):
+    """dallas/maxim 1-wire crc"""
+    crc = 0
+    for b in data:
+        for _ in range(8):
+            mix = (crc ^ b) & 1
+            crc >>= 1
+            if mix:
+                crc ^= 0x8C
+            b >>= 1
+    return crc
+
+
+def scratchpad(celsius=None, raw=None, crc=None):
+    """w1_slave contents for a DS18B20 reading celsius"""
+    if raw is None:
+        raw = round(celsius * 16)
+    data = struct.pack('<h', raw) + bytes([0x4b, 0x46, 0x7f, 0xff, 0x0c, 0x10])
+    data += bytes([crc8(data) if crc is None else crc])
+    line = ' '.join('%02x' % b for b in data)
+    return '%s : crc=%02x YES\n%s t=%d\n' % (line, data[8], line, raw * 1000 // 16)
+
+
+class W1SensorTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.TemporaryDirectory()
+        # the sensor takes the device directory, like /sys/bus/w1/devices/28-*
+        self.device = os.path.join(self.dir.name, '28-000000000001')
+        os.mkdir(self.device)
+        self.write(scratchpad(23.125))
+        self.chamber = Chamber()
+        self.tc = self.chamber.tc
+        self.tc.setBeerSensor(path=self.device)
+        self.tc.setMode(TempControl.MODE_BEER_CONSTANT)
+        self.recorder = self.tc.setRecorder(16)
+
+    def tearDown(self):
+        self.chamber = self.tc = self.recorder = None
+        self.dir.cleanup()
+
+    def write(self, text):
+        with open(os.path.join(self.device, 'w1_slave'), 'w') as f:
+            f.write(text)
+
+    def beerTemps(self, ticks):
+        self.recorder.clear()
+        for _ in range(ticks):
+            self.tc.tick()
+        data = bytes(self.recorder)
+        return [struct.unpack_from('<qh', data, n * 40)[1] for n in range(ticks)]
+
+    def assertIgnored(self, text):
+        self.write(text)
+        self.assertEqual(self.beerTemps(5), [fixed(23.125)] * 5)
+
+    def testValidScratchpad(self):
+        self.assertEqual(self.beerTemps(3), [fixed(23.125)] * 3)
+        # and a change does come through, so the cases below mean something
+        self.write(scratchpad(30.0))
+        temps = self.beerTemps(5)
+        self.assertGreater(temps[-1], fixed(23.125))
+
+    def testCrcFailure(self):
+        good = scratchpad(30.0)
+        crc = int(good[24:26], 16)
+        self.assertIgnored(scratchpad(30.0, crc=crc ^ 0x01))
+
+    def testPowerOnValue(self):
+        # 0x0550 is 85 degrees, what the sensor holds before converting
+        self.assertIgnored(scratchpad(raw=0x0550))
+
+    def testAllZero(self):
+        # a shorted bus, the crc of all zeros is zero
+        self.assertIgnored(' '.join(['00'] * 9) + ' : crc=00 YES\n')